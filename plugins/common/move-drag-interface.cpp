@@ -106,7 +106,8 @@ public:
 
     void render(const wf::scene::render_instruction_t &data) override {
       auto bbox = self->get_bounding_box();
-      auto tex = this->get_texture(data.target.scale);
+      auto tex = this->get_texture(
+          self->get_content_scale(data.target.scale, 1.0 / self->scale_factor));
       data.pass->add_texture(tex, data.target, bbox, data.damage,
                              self->alpha_factor);
     }
@@ -241,13 +242,10 @@ struct core_drag_t::impl {
 
   std::shared_ptr<dragged_view_node_t> render_node;
 
-  wf::effect_hook_t on_pre_frame = [=]() {
-    for (auto &v : this->all_views) {
-      if (v.transformer->scale_factor.running()) {
-        v.view->damage();
-      }
-    }
-  };
+  // The latest motion which has not been applied to the views yet
+  std::optional<wf::point_t> pending_motion;
+
+  wf::effect_hook_t on_pre_frame;
 
   wf::signal::connection_t<view_unmapped_signal> on_view_unmap;
   wf::signal::connection_t<output_removed_signal> on_output_removed;
@@ -258,6 +256,15 @@ core_drag_t::core_drag_t() {
 
   priv->on_view_unmap = [=](auto *ev) { handle_input_released(); };
 
+  priv->on_pre_frame = [=]() {
+    apply_pending_motion();
+    for (auto &v : priv->all_views) {
+      if (v.transformer->scale_factor.running()) {
+        v.view->damage();
+      }
+    }
+  };
+
   priv->on_output_removed = [=](wf::output_removed_signal *ev) {
     if (current_output == ev->output) {
       update_current_output(nullptr);
@@ -383,6 +390,26 @@ void core_drag_t::handle_motion(wf::point_t to) {
     }
   }
 
+  // Motion events usually arrive much more often than frames, so only the
+  // latest position is applied, at the start of the next frame. Outputs which
+  // do not render frames would never apply it, so it is applied right away.
+  priv->pending_motion = to;
+  if (current_output && current_output->handle->enabled &&
+      !current_output->render->is_inhibited()) {
+    current_output->render->schedule_redraw();
+  } else {
+    apply_pending_motion();
+  }
+}
+
+void core_drag_t::apply_pending_motion() {
+  if (!priv->pending_motion) {
+    return;
+  }
+
+  auto to = *priv->pending_motion;
+  priv->pending_motion.reset();
+
   // Update wobbly independently of the grab position.
   // This is because while held in place, wobbly is anchored to its edges
   // so we can still move the grabbed point without moving the view.
@@ -413,6 +440,9 @@ void core_drag_t::handle_input_released() {
     return;
   }
 
+  // The views should be dropped where the input was released
+  apply_pending_motion();
+
   // Store data for the drag done signal
   drag_done_signal data;
   data.grab_position = priv->all_views.front().transformer->grab_position;
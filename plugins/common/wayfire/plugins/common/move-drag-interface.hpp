@@ -195,6 +195,13 @@ class core_drag_t : public signal::provider_t
     void start_drag(wayfire_toplevel_view grab_view, wf::pointf_t relative, const drag_options_t& options);
     void start_drag(wayfire_toplevel_view view, const drag_options_t& options);
 
+    /**
+     * Move the dragged views to the given position, in output-layout coordinates.
+     *
+     * The views are moved and drag_motion_signal is emitted at the start of the
+     * next frame of the current output, so that multiple motion events between
+     * two frames result in a single update with the latest position.
+     */
     void handle_motion(wf::point_t to);
 
     double distance_to_grab_origin(wf::point_t to) const;
@@ -216,6 +223,7 @@ class core_drag_t : public signal::provider_t
 
     void update_current_output(wf::point_t grab);
     void update_current_output(wf::output_t *output);
+    void apply_pending_motion();
 };
 
 /**
@@ -12,6 +12,12 @@
 #include "wayfire/signal-provider.hpp"
 #include "wayfire/output.hpp"
 
+struct wlr_texture;
+namespace image_io
+{
+class async_load_t;
+}
+
 namespace wf
 {
 /**
@@ -47,6 +53,16 @@ class workspace_wall_t : public wf::signal::provider_t
      */
     void set_background_color(const wf::color_t& color);
 
+    /**
+     * Draw an image, scaled to the output, over the background color.
+     *
+     * The image is decoded in the background, until it is ready only the
+     * background color is visible.
+     *
+     * @param path The image file, or an empty string to remove the image.
+     */
+    void set_background_image(const std::string& path);
+
     /**
      * Set the size of the gap between adjacent workspaces, both horizontally
      * and vertically.
@@ -115,6 +131,10 @@ class workspace_wall_t : public wf::signal::provider_t
     wf::output_t *output;
 
     wf::color_t background_color = {0, 0, 0, 0};
+    std::string background_path;
+    wf::dimensions_t background_size = {0, 0};
+    wlr_texture *background_texture  = nullptr;
+    std::unique_ptr<image_io::async_load_t> background_load;
     int gap_size = 0;
     wf::geometry_t viewport = {0, 0, 0, 0};
     std::map<std::pair<int, int>, float> render_colors;
@@ -6,7 +6,12 @@
 #include "wayfire/scene.hpp"
 #include "wayfire/region.hpp"
 #include "wayfire/core.hpp"
+#include "wayfire/img.hpp"
+#include "wayfire/nonstd/wlroots-full.hpp"
+#include <wayfire/util/log.hpp>
 
+#include <cmath>
+#include <drm_fourcc.h>
 #include <glm/gtc/matrix_transform.hpp>
 
 namespace wf
@@ -187,6 +192,12 @@ class workspace_wall_t::workspace_wall_node_t : public scene::node_t
         void render(const wf::scene::render_instruction_t& data) override
         {
             data.pass->clear(data.damage, self->wall->background_color);
+            if (self->wall->background_texture)
+            {
+                auto tex = wf::texture_t{self->wall->background_texture};
+                tex.filter_mode = WLR_SCALE_FILTER_BILINEAR;
+                data.pass->add_texture(tex, data.target, self->get_bounding_box(), data.damage);
+            }
 
             auto damage = data.target.framebuffer_region_from_geometry_region(data.damage);
             for (int i = 0; i < (int)self->workspaces.size(); i++)
@@ -312,6 +323,11 @@ workspace_wall_t::workspace_wall_t(wf::output_t *_output) : output(_output)
 workspace_wall_t::~workspace_wall_t()
 {
     stop_output_renderer(false);
+    background_load.reset();
+    if (background_texture)
+    {
+        wlr_texture_destroy(background_texture);
+    }
 }
 
 void workspace_wall_t::set_background_color(const wf::color_t& color)
@@ -319,6 +335,51 @@ void workspace_wall_t::set_background_color(const wf::color_t& color)
     this->background_color = color;
 }
 
+void workspace_wall_t::set_background_image(const std::string& path)
+{
+    // Decode the image at the size it is shown with, so that it does not need
+    // to be scaled on every frame.
+    auto size = output->get_screen_size();
+    size.width  = std::round(size.width * output->handle->scale);
+    size.height = std::round(size.height * output->handle->scale);
+    if ((path == background_path) && (size == background_size))
+    {
+        return;
+    }
+
+    background_path = path;
+    background_size = size;
+    background_load.reset();
+    if (background_texture)
+    {
+        wlr_texture_destroy(background_texture);
+        background_texture = nullptr;
+    }
+
+    if (path.empty())
+    {
+        return;
+    }
+
+    background_load = image_io::load_from_file_async(path, size,
+        [=] (std::shared_ptr<image_io::decoded_image_t> image)
+    {
+        if (!image)
+        {
+            LOGE("Failed to load the background image ", path);
+            return;
+        }
+
+        uint32_t format = (image->channels == 4) ? DRM_FORMAT_ABGR8888 : DRM_FORMAT_BGR888;
+        background_texture = wlr_texture_from_pixels(wf::get_core().renderer, format,
+            image->width * image->channels, image->width, image->height, image->data.data());
+        if (render_node)
+        {
+            scene::damage_node(render_node, render_node->get_bounding_box());
+        }
+    });
+}
+
 void workspace_wall_t::set_gap_size(int size)
 {
     this->gap_size = size;
@@ -26,6 +26,9 @@ namespace grid {
  *
  * It fades out the scaled contents from original_buffer, and fades in the
  * current contents of the view, based on the alpha value in the transformer.
+ *
+ * If the old contents are not captured, the transformer only scales and
+ * translates the current contents of the view to the displayed geometry.
  */
 class crossfade_node_t : public scene::view_2d_transformer_t {
 public:
@@ -36,10 +39,16 @@ public:
 public:
   wf::geometry_t displayed_geometry;
   double overlay_alpha;
+  // Whether original_buffer holds the old contents of the view.
+  const bool has_contents;
 
-  crossfade_node_t(wayfire_toplevel_view view) : view_2d_transformer_t(view) {
+  crossfade_node_t(wayfire_toplevel_view view, bool capture_contents = true)
+      : view_2d_transformer_t(view), has_contents(capture_contents) {
     displayed_geometry = view->get_geometry();
     this->view = view;
+    if (!capture_contents) {
+      return;
+    }
 
     auto root_node = view->get_surface_root_node();
     const wf::geometry_t bbox = root_node->get_bounding_box();
@@ -141,8 +150,10 @@ inline void crossfade_node_t::gen_render_instances(
     std::vector<scene::render_instance_uptr> &instances,
     scene::damage_callback push_damage, wf::output_t *shown_on) {
   // Step 2: render overlay (instances are sorted front-to-back)
-  instances.push_back(
-      std::make_unique<crossfade_render_instance_t>(this, push_damage));
+  if (has_contents) {
+    instances.push_back(
+        std::make_unique<crossfade_render_instance_t>(this, push_damage));
+  }
 
   // Step 1: render the scaled view
   scene::view_2d_transformer_t::gen_render_instances(instances, push_damage,
@@ -156,6 +167,9 @@ class grid_animation_t : public wf::custom_data_t {
 public:
   enum type_t {
     CROSSFADE,
+    // Like CROSSFADE, but the current contents of the view are scaled to the
+    // animated geometry, without keeping a copy of the old contents.
+    TRANSFORM,
     NONE,
   };
 
@@ -164,7 +178,7 @@ public:
    *
    * @param type Indicates which animation method to use.
    * @param duration Indicates the duration of the animation (only for
-   * crossfade)
+   * crossfade and transform)
    */
   grid_animation_t(wayfire_toplevel_view view, type_t type,
                    wf::option_sptr_t<wf::animation_description_t> duration) {
@@ -200,7 +214,7 @@ public:
       tx->add_object(view->toplevel());
     };
 
-    if (type != CROSSFADE) {
+    if (type == NONE) {
       /* Order is important here: first we set the view geometry, and
        * after that we set the snap request. Otherwise the wobbly plugin
        * will think the view actually moved */
@@ -216,7 +230,8 @@ public:
     animation.start();
 
     // Add crossfade transformer
-    ensure_view_transformer<crossfade_node_t>(view, wf::TRANSFORMER_2D, view);
+    ensure_view_transformer<crossfade_node_t>(view, wf::TRANSFORMER_2D, view,
+                                              type == CROSSFADE);
 
     // Start the transition
     set_state();
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace wf
+{
+namespace ipc_rules
+{
+/**
+ * Tracks when the objects of one kind (views, outputs or workspace sets)
+ * last changed, so that the list methods can return only the objects which
+ * changed since a generation the client has seen before.
+ */
+class generation_tracker_t
+{
+  public:
+    /**
+     * @param start The first generation. By default, the current time in
+     *   microseconds, so that generations handed out by a previous instance
+     *   (for example before the plugin was reloaded) are older than all
+     *   generations of this one and are not mistaken for them.
+     */
+    explicit generation_tracker_t(uint64_t start = current_time_us()) :
+        generation(start), forgotten_until(start)
+    {}
+
+    /** Mark the object with the given id as changed. */
+    void bump(uint64_t id)
+    {
+        changed_at[id] = ++generation;
+    }
+
+    /** Mark all known objects as changed. */
+    void bump_all()
+    {
+        for (auto& [id, gen] : changed_at)
+        {
+            gen = ++generation;
+        }
+    }
+
+    /**
+     * Update the tracker with the objects which currently exist. Objects which
+     * were never seen are marked as changed, and objects which no longer exist
+     * are remembered as removed.
+     */
+    void sync(const std::vector<uint64_t>& live_ids)
+    {
+        std::unordered_set<uint64_t> live{live_ids.begin(), live_ids.end()};
+        for (auto it = changed_at.begin(); it != changed_at.end();)
+        {
+            if (live.count(it->first))
+            {
+                ++it;
+                continue;
+            }
+
+            removed.push_back({++generation, it->first});
+            it = changed_at.erase(it);
+        }
+
+        for (auto& id : live_ids)
+        {
+            if (!changed_at.count(id))
+            {
+                bump(id);
+            }
+        }
+
+        while (removed.size() > MAX_REMOVED)
+        {
+            forgotten_until = removed.front().first;
+            removed.erase(removed.begin());
+        }
+    }
+
+    uint64_t get_generation() const
+    {
+        return generation;
+    }
+
+    /**
+     * @return Whether the changes since @since can be described as a delta, or
+     *   the client needs the full list (the generation is from another
+     *   instance of the tracker, or removals it has not seen were forgotten).
+     */
+    bool can_diff(uint64_t since) const
+    {
+        return since <= generation && since >= forgotten_until;
+    }
+
+    bool changed_since(uint64_t id, uint64_t since) const
+    {
+        auto it = changed_at.find(id);
+        return it == changed_at.end() || it->second > since;
+    }
+
+    std::vector<uint64_t> removed_since(uint64_t since) const
+    {
+        std::vector<uint64_t> ids;
+        for (auto& [gen, id] : removed)
+        {
+            if (gen > since)
+            {
+                ids.push_back(id);
+            }
+        }
+
+        return ids;
+    }
+
+    static constexpr size_t MAX_REMOVED = 256;
+
+  private:
+    static uint64_t current_time_us()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+
+    uint64_t generation;
+    uint64_t forgotten_until;
+    std::unordered_map<uint64_t, uint64_t> changed_at;
+    /* (generation, id) of removed objects, oldest first */
+    std::vector<std::pair<uint64_t, uint64_t>> removed;
+};
+}
+}
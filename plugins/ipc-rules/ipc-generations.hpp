@@ -0,0 +1,152 @@
+#pragma once
+
+#include "ipc-rules-common.hpp"
+#include "generation-tracker.hpp"
+#include "wayfire/output-layout.hpp"
+#include <wayfire/signal-definitions.hpp>
+#include <wayfire/nonstd/tracking-allocator.hpp>
+#include "plugins/wm-actions/wm-actions-signals.hpp"
+
+namespace wf
+{
+/**
+ * Keeps a change generation for each view, output and workspace set, bumped
+ * from the signals which affect their IPC description.
+ *
+ * It has to be initialized before the IPC events, so that cached view
+ * snapshots are invalidated before events with the new state are sent.
+ */
+class ipc_rules_generations_t
+{
+  public:
+    void init_generations()
+    {
+        wf::get_core().connect(&gen_view_mapped);
+        wf::get_core().connect(&gen_view_unmapped);
+        wf::get_core().connect(&gen_view_set_output);
+        wf::get_core().connect(&gen_view_geometry_changed);
+        wf::get_core().connect(&gen_view_moved_to_wset);
+        wf::get_core().connect(&gen_view_title_changed);
+        wf::get_core().connect(&gen_view_app_id_changed);
+        wf::get_core().connect(&gen_kbfocus_changed);
+        wf::get_core().output_layout->connect(&gen_output_added);
+        wf::get_core().output_layout->connect(&gen_output_layout_changed);
+        for (auto& wo : wf::get_core().output_layout->get_outputs())
+        {
+            connect_output_generations(wo);
+        }
+    }
+
+    void fini_generations()
+    {
+        // The cached snapshots are connected to view signals with our code
+        wf::tracking_allocator_t<wf::view_interface_t>::get().for_each([] (wayfire_view view)
+        {
+            view->erase_data<ipc_rules::view_snapshot_t>();
+        });
+    }
+
+    ipc_rules::generation_tracker_t view_generations;
+    ipc_rules::generation_tracker_t output_generations;
+    ipc_rules::generation_tracker_t wset_generations;
+
+  private:
+    uint64_t last_focused_view = 0;
+
+    void bump_view(wayfire_view view)
+    {
+        if (view)
+        {
+            view_generations.bump(view->get_id());
+        }
+    }
+
+    void bump_output(wf::output_t *output)
+    {
+        if (output)
+        {
+            output_generations.bump(output->get_id());
+            wset_generations.bump(output->wset()->get_index());
+        }
+    }
+
+    void connect_output_generations(wf::output_t *output)
+    {
+        output->connect(&gen_view_tiled);
+        output->connect(&gen_view_minimized);
+        output->connect(&gen_view_fullscreen);
+        output->connect(&gen_view_sticky);
+        output->connect(&gen_view_above);
+        output->connect(&gen_workarea_changed);
+        output->connect(&gen_workspace_changed);
+        output->connect(&gen_wset_changed);
+    }
+
+    wf::signal::connection_t<wf::view_mapped_signal> gen_view_mapped =
+        [=] (wf::view_mapped_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::view_unmapped_signal> gen_view_unmapped =
+        [=] (wf::view_unmapped_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::view_set_output_signal> gen_view_set_output =
+        [=] (wf::view_set_output_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::view_geometry_changed_signal> gen_view_geometry_changed =
+        [=] (wf::view_geometry_changed_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::view_moved_to_wset_signal> gen_view_moved_to_wset =
+        [=] (wf::view_moved_to_wset_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::view_title_changed_signal> gen_view_title_changed =
+        [=] (wf::view_title_changed_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::view_app_id_changed_signal> gen_view_app_id_changed =
+        [=] (wf::view_app_id_changed_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::view_tiled_signal> gen_view_tiled =
+        [=] (wf::view_tiled_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::view_minimized_signal> gen_view_minimized =
+        [=] (wf::view_minimized_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::view_fullscreen_signal> gen_view_fullscreen =
+        [=] (wf::view_fullscreen_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::view_set_sticky_signal> gen_view_sticky =
+        [=] (wf::view_set_sticky_signal *ev) { bump_view(ev->view); };
+    wf::signal::connection_t<wf::wm_actions_above_changed_signal> gen_view_above =
+        [=] (wf::wm_actions_above_changed_signal *ev)
+    {
+        ipc_rules::view_snapshot_t::invalidate(ev->view);
+        bump_view(ev->view);
+    };
+
+    // Focus changes the activated state and the focus timestamp of both the
+    // previously and the newly focused view.
+    wf::signal::connection_t<wf::keyboard_focus_changed_signal> gen_kbfocus_changed =
+        [=] (wf::keyboard_focus_changed_signal *ev)
+    {
+        if (last_focused_view)
+        {
+            view_generations.bump(last_focused_view);
+        }
+
+        auto view = wf::node_to_view(ev->new_focus);
+        last_focused_view = view ? view->get_id() : 0;
+        bump_view(view);
+    };
+
+    wf::signal::connection_t<wf::output_added_signal> gen_output_added =
+        [=] (wf::output_added_signal *ev)
+    {
+        connect_output_generations(ev->output);
+        bump_output(ev->output);
+    };
+
+    wf::signal::connection_t<wf::output_layout_configuration_changed_signal> gen_output_layout_changed =
+        [=] (wf::output_layout_configuration_changed_signal *ev) { output_generations.bump_all(); };
+    wf::signal::connection_t<wf::workarea_changed_signal> gen_workarea_changed =
+        [=] (wf::workarea_changed_signal *ev) { bump_output(ev->output); };
+    wf::signal::connection_t<wf::workspace_changed_signal> gen_workspace_changed =
+        [=] (wf::workspace_changed_signal *ev) { bump_output(ev->output); };
+
+    // The previous workspace set of the output is detached, which changes
+    // its output fields as well.
+    wf::signal::connection_t<wf::workspace_set_changed_signal> gen_wset_changed =
+        [=] (wf::workspace_set_changed_signal *ev)
+    {
+        bump_output(ev->output);
+        wset_generations.bump_all();
+    };
+};
+}
@@ -10,10 +10,57 @@
 #include <wayfire/nonstd/wlroots-full.hpp>
 #include <wayfire/unstable/wlr-surface-node.hpp>
 #include <wayfire/view-helpers.hpp>
+#include <wayfire/signal-definitions.hpp>
+#include <set>
 
 namespace wf::ipc_rules
 {
-static inline wf::json_t output_to_json(wf::output_t *o)
+/**
+ * The top-level fields of an object which an IPC client asked for, see the
+ * `fields` argument of the list methods. An empty filter selects all fields.
+ */
+struct field_filter_t
+{
+    std::set<std::string> fields;
+
+    bool operator ()(const std::string& field) const
+    {
+        return fields.empty() || fields.count(field);
+    }
+};
+
+/**
+ * Read the optional `fields` array of an IPC request into @filter.
+ *
+ * @return An error message if the array is malformed.
+ */
+static inline std::optional<std::string> field_filter_from_json(const wf::json_t& data,
+    field_filter_t& filter)
+{
+    if (!data.has_member("fields"))
+    {
+        return {};
+    }
+
+    if (!data["fields"].is_array())
+    {
+        return "fields must be an array of strings";
+    }
+
+    for (size_t i = 0; i < data["fields"].size(); i++)
+    {
+        if (!data["fields"][i].is_string())
+        {
+            return "fields must be an array of strings";
+        }
+
+        filter.fields.insert(data["fields"][i].as_string());
+    }
+
+    return {};
+}
+
+static inline wf::json_t output_to_json(wf::output_t *o, const field_filter_t& want = {})
 {
     if (!o)
     {
@@ -21,15 +68,39 @@ static inline wf::json_t output_to_json(wf::output_t *o)
     }
 
     wf::json_t response;
-    response["id"]   = o->get_id();
-    response["name"] = o->to_string();
-    response["geometry"]   = wf::ipc::geometry_to_json(o->get_layout_geometry());
-    response["workarea"]   = wf::ipc::geometry_to_json(o->workarea->get_workarea());
-    response["wset-index"] = o->wset()->get_index();
-    response["workspace"]["x"] = o->wset()->get_current_workspace().x;
-    response["workspace"]["y"] = o->wset()->get_current_workspace().y;
-    response["workspace"]["grid_width"]  = o->wset()->get_workspace_grid_size().width;
-    response["workspace"]["grid_height"] = o->wset()->get_workspace_grid_size().height;
+    if (want("id"))
+    {
+        response["id"] = o->get_id();
+    }
+
+    if (want("name"))
+    {
+        response["name"] = o->to_string();
+    }
+
+    if (want("geometry"))
+    {
+        response["geometry"] = wf::ipc::geometry_to_json(o->get_layout_geometry());
+    }
+
+    if (want("workarea"))
+    {
+        response["workarea"] = wf::ipc::geometry_to_json(o->workarea->get_workarea());
+    }
+
+    if (want("wset-index"))
+    {
+        response["wset-index"] = o->wset()->get_index();
+    }
+
+    if (want("workspace"))
+    {
+        response["workspace"]["x"] = o->wset()->get_current_workspace().x;
+        response["workspace"]["y"] = o->wset()->get_current_workspace().y;
+        response["workspace"]["grid_width"]  = o->wset()->get_workspace_grid_size().width;
+        response["workspace"]["grid_height"] = o->wset()->get_workspace_grid_size().height;
+    }
+
     return response;
 }
 
@@ -169,51 +240,161 @@ static inline std::string get_view_type(wayfire_view view)
     return "unknown";
 }
 
-static inline wf::json_t view_to_json(wayfire_view view)
+/**
+ * The parts of the IPC description of a view which are expensive to compute
+ * or change rarely, cached on the view.
+ *
+ * The snapshot is invalidated by the signals of the view itself, which are
+ * emitted before the output and core signals which the IPC events are sent
+ * from. Changes which are signalled only on the output or core are handled
+ * by ipc_rules_generations_t, which connects before the event handlers.
+ */
+class view_snapshot_t : public wf::custom_data_t
+{
+  public:
+    pid_t pid = -1;
+    std::string title;
+    std::string app_id;
+    int parent = -1;
+    uint32_t output_id = -1;
+    std::string output_name;
+    std::string role;
+    std::string layer;
+    std::string type;
+    bool always_on_top = false;
+
+    static void invalidate(wayfire_view view)
+    {
+        if (auto snapshot = view->get_data<view_snapshot_t>())
+        {
+            snapshot->valid = false;
+        }
+    }
+
+    const view_snapshot_t& get(wayfire_view view)
+    {
+        // The layer depends on where the view is in the scenegraph, which can
+        // change without a signal, for ex. when a layer surface changes layers.
+        // Child views are nested under their parent's node, so the layer has to
+        // be found by walking up to the layer node, their own parent node does
+        // not change when the parent view moves to another layer.
+        auto view_layer = wf::get_view_layer(view);
+        if (valid && (view_layer == this->view_layer))
+        {
+            return *this;
+        }
+
+        if (!on_mapped.is_connected())
+        {
+            pid = get_view_pid(view);
+            view->connect(&on_mapped);
+            view->connect(&on_unmapped);
+            view->connect(&on_set_output);
+            view->connect(&on_title_changed);
+            view->connect(&on_app_id_changed);
+            view->connect(&on_parent_changed);
+        }
+
+        auto output   = view->get_output();
+        auto toplevel = wf::toplevel_cast(view);
+        title  = view->get_title();
+        app_id = view->get_app_id();
+        parent = toplevel && toplevel->parent ? (int)toplevel->parent->get_id() : -1;
+        output_id   = output ? output->get_id() : -1;
+        output_name = output ? output->to_string() : "null";
+        role  = role_to_string(view->role);
+        layer = layer_to_string(view_layer);
+        type  = get_view_type(view);
+        always_on_top = view->has_data("wm-actions-above");
+
+        this->view_layer = view_layer;
+        valid = true;
+        return *this;
+    }
+
+  private:
+    bool valid = false;
+    std::optional<wf::scene::layer> view_layer;
+
+    wf::signal::connection_t<wf::view_mapped_signal> on_mapped =
+        [=] (wf::view_mapped_signal*) { valid = false; };
+    wf::signal::connection_t<wf::view_unmapped_signal> on_unmapped =
+        [=] (wf::view_unmapped_signal*) { valid = false; };
+    wf::signal::connection_t<wf::view_set_output_signal> on_set_output =
+        [=] (wf::view_set_output_signal*) { valid = false; };
+    wf::signal::connection_t<wf::view_title_changed_signal> on_title_changed =
+        [=] (wf::view_title_changed_signal*) { valid = false; };
+    wf::signal::connection_t<wf::view_app_id_changed_signal> on_app_id_changed =
+        [=] (wf::view_app_id_changed_signal*) { valid = false; };
+    wf::signal::connection_t<wf::view_parent_changed_signal> on_parent_changed =
+        [=] (wf::view_parent_changed_signal*) { valid = false; };
+};
+
+static inline wf::json_t view_to_json(wayfire_view view, const field_filter_t& want = {})
 {
     if (!view)
     {
         return wf::json_t::null();
     }
 
-    auto output = view->get_output();
-    wf::json_t description;
-    description["id"]     = view->get_id();
-    description["pid"]    = get_view_pid(view);
-    description["title"]  = view->get_title();
-    description["app-id"] = view->get_app_id();
-    description["base-geometry"] = wf::ipc::geometry_to_json(get_view_base_geometry(view));
     auto toplevel = wf::toplevel_cast(view);
-    description["parent"]   = toplevel && toplevel->parent ? (int)toplevel->parent->get_id() : -1;
-    description["geometry"] =
-        wf::ipc::geometry_to_json(toplevel ? toplevel->get_pending_geometry() : view->get_bounding_box());
-    description["bbox"] = wf::ipc::geometry_to_json(view->get_bounding_box());
-    description["output-id"]   = view->get_output() ? view->get_output()->get_id() : -1;
-    description["output-name"] = output ? output->to_string() : "null";
-    description["last-focus-timestamp"] = wf::get_focus_timestamp(view);
-    description["role"]   = role_to_string(view->role);
-    description["mapped"] = view->is_mapped();
-    description["layer"]  = layer_to_string(get_view_layer(view));
-    description["tiled-edges"] = toplevel ? toplevel->pending_tiled_edges() : 0;
-    description["fullscreen"]  = toplevel ? toplevel->pending_fullscreen() : false;
-    description["minimized"]   = toplevel ? toplevel->minimized : false;
-    description["activated"]   = toplevel ? toplevel->activated : false;
-    description["sticky"]     = toplevel ? toplevel->sticky : false;
-    description["wset-index"] = toplevel && toplevel->get_wset() ?
-        static_cast<int64_t>(toplevel->get_wset()->get_index()) :
-        -1;
-    description["min-size"] = wf::ipc::dimensions_to_json(
-        toplevel ? toplevel->toplevel()->get_min_size() : wf::dimensions_t{0, 0});
-    description["max-size"] = wf::ipc::dimensions_to_json(
-        toplevel ? toplevel->toplevel()->get_max_size() : wf::dimensions_t{0, 0});
-    description["focusable"] = view->is_focusable();
-    description["type"] = get_view_type(view);
-    description["always-on-top"] = view->has_data("wm-actions-above");
+    auto& snapshot = view->get_data_safe<view_snapshot_t>()->get(view);
+    wf::json_t description;
+    // Fields which are not requested are not computed at all
+    auto set = [&] (const char *field, auto value)
+    {
+        if (want(field))
+        {
+            description[field] = value();
+        }
+    };
+
+    set("id", [&] { return view->get_id(); });
+    set("pid", [&] { return snapshot.pid; });
+    set("title", [&] { return snapshot.title; });
+    set("app-id", [&] { return snapshot.app_id; });
+    set("base-geometry", [&] { return wf::ipc::geometry_to_json(get_view_base_geometry(view)); });
+    set("parent", [&] { return snapshot.parent; });
+    set("geometry", [&]
+    {
+        return wf::ipc::geometry_to_json(
+            toplevel ? toplevel->get_pending_geometry() : view->get_bounding_box());
+    });
+    set("bbox", [&] { return wf::ipc::geometry_to_json(view->get_bounding_box()); });
+    set("output-id", [&] { return snapshot.output_id; });
+    set("output-name", [&] { return snapshot.output_name; });
+    set("last-focus-timestamp", [&] { return wf::get_focus_timestamp(view); });
+    set("role", [&] { return snapshot.role; });
+    set("mapped", [&] { return view->is_mapped(); });
+    set("layer", [&] { return snapshot.layer; });
+    set("tiled-edges", [&] { return toplevel ? toplevel->pending_tiled_edges() : 0; });
+    set("fullscreen", [&] { return toplevel ? toplevel->pending_fullscreen() : false; });
+    set("minimized", [&] { return toplevel ? toplevel->minimized : false; });
+    set("activated", [&] { return toplevel ? toplevel->activated : false; });
+    set("sticky", [&] { return toplevel ? toplevel->sticky : false; });
+    set("wset-index", [&]
+    {
+        return toplevel && toplevel->get_wset() ?
+               static_cast<int64_t>(toplevel->get_wset()->get_index()) : -1;
+    });
+    set("min-size", [&]
+    {
+        return wf::ipc::dimensions_to_json(
+            toplevel ? toplevel->toplevel()->get_min_size() : wf::dimensions_t{0, 0});
+    });
+    set("max-size", [&]
+    {
+        return wf::ipc::dimensions_to_json(
+            toplevel ? toplevel->toplevel()->get_max_size() : wf::dimensions_t{0, 0});
+    });
+    set("focusable", [&] { return view->is_focusable(); });
+    set("type", [&] { return snapshot.type; });
+    set("always-on-top", [&] { return snapshot.always_on_top; });
 
     return description;
 }
 
-static inline wf::json_t wset_to_json(wf::workspace_set_t *wset)
+static inline wf::json_t wset_to_json(wf::workspace_set_t *wset, const field_filter_t& want = {})
 {
     if (!wset)
     {
@@ -221,16 +402,28 @@ static inline wf::json_t wset_to_json(wf::workspace_set_t *wset)
     }
 
     wf::json_t response;
-    response["index"] = wset->get_index();
-    response["name"]  = wset->to_string();
-
     auto output = wset->get_attached_output();
-    response["output-id"]   = output ? (int)output->get_id() : -1;
-    response["output-name"] = output ? output->to_string() : "";
-    response["workspace"]["x"] = wset->get_current_workspace().x;
-    response["workspace"]["y"] = wset->get_current_workspace().y;
-    response["workspace"]["grid_width"]  = wset->get_workspace_grid_size().width;
-    response["workspace"]["grid_height"] = wset->get_workspace_grid_size().height;
+    auto set = [&] (const char *field, auto value)
+    {
+        if (want(field))
+        {
+            response[field] = value();
+        }
+    };
+
+    set("index", [&] { return wset->get_index(); });
+    set("name", [&] { return wset->to_string(); });
+    set("output-id", [&] { return output ? (int)output->get_id() : -1; });
+    set("output-name", [&] { return output ? output->to_string() : ""; });
+
+    if (want("workspace"))
+    {
+        response["workspace"]["x"] = wset->get_current_workspace().x;
+        response["workspace"]["y"] = wset->get_current_workspace().y;
+        response["workspace"]["grid_width"]  = wset->get_workspace_grid_size().width;
+        response["workspace"]["grid_height"] = wset->get_workspace_grid_size().height;
+    }
+
     return response;
 }
 
@@ -11,16 +11,19 @@
 #include "wayfire/window-manager.hpp"
 #include <wayfire/debug.hpp>
 #include <wayfire/signal-definitions.hpp>
+#include <wayfire/nonstd/tracking-allocator.hpp>
 
 #include "ipc-rules-common.hpp"
 #include "ipc-input-methods.hpp"
 #include "ipc-utility-methods.hpp"
 #include "ipc-events.hpp"
+#include "ipc-generations.hpp"
 
 class ipc_rules_t : public wf::plugin_interface_t,
     public wf::ipc_rules_input_methods_t,
     public wf::ipc_rules_utility_methods_t,
-    public wf::ipc_rules_events_methods_t
+    public wf::ipc_rules_events_methods_t,
+    public wf::ipc_rules_generations_t
 {
   public:
     void init() override
@@ -40,6 +43,7 @@ class ipc_rules_t : public wf::plugin_interface_t,
         method_repository->register_method("window-rules/set-view-property", set_view_property);
         method_repository->register_method("window-rules/get-view-property", get_view_property);
 
+        init_generations();
         init_input_methods(method_repository.get());
         init_utility_methods(method_repository.get());
         init_events(method_repository.get());
@@ -65,18 +69,97 @@ class ipc_rules_t : public wf::plugin_interface_t,
         fini_input_methods(method_repository.get());
         fini_utility_methods(method_repository.get());
         fini_events(method_repository.get());
+        fini_generations();
     }
 
-    wf::ipc::method_callback list_views = [=] (wf::json_t)
+    /**
+     * Build the response of a list method.
+     *
+     * By default, all objects are listed in an array. The optional `fields`
+     * argument limits the fields included for each object. With the optional
+     * `since` argument, the response is an object instead, which contains
+     * the current `generation`, the objects which changed after the `since`
+     * generation and the ids of the objects removed after it. If the changes
+     * cannot be computed (e.g. the generation is too old), all objects are
+     * listed and `full` is set.
+     */
+    template<class Object, class GetId, class ToJson>
+    wf::json_t list_objects(const wf::json_t& data, const std::vector<Object>& objects,
+        wf::ipc_rules::generation_tracker_t& tracker, GetId get_id, ToJson to_json)
     {
-        wf::json_t response = wf::json_t::array();
-        for (auto& view : wf::get_core().get_all_views())
+        wf::ipc_rules::field_filter_t fields;
+        if (auto error = wf::ipc_rules::field_filter_from_json(data, fields))
         {
-            wf::json_t v = wf::ipc_rules::view_to_json(view);
-            response.append(v);
+            return wf::ipc::json_error(*error);
+        }
+
+        auto since = wf::ipc::json_get_optional_uint64(data, "since");
+        if (!since.has_value())
+        {
+            wf::json_t response = wf::json_t::array();
+            for (auto& object : objects)
+            {
+                if (object)
+                {
+                    response.append(to_json(object, fields));
+                }
+            }
+
+            return response;
+        }
+
+        std::vector<uint64_t> ids;
+        ids.reserve(objects.size());
+        for (auto& object : objects)
+        {
+            if (object)
+            {
+                ids.push_back(get_id(object));
+            }
+        }
+
+        tracker.sync(ids);
+        bool full = !tracker.can_diff(*since);
+
+        wf::json_t response;
+        response["generation"] = tracker.get_generation();
+        response["full"]    = full;
+        response["changed"] = wf::json_t::array();
+        response["removed"] = wf::json_t::array();
+        size_t next_id = 0;
+        for (auto& object : objects)
+        {
+            if (!object)
+            {
+                continue;
+            }
+
+            uint64_t id = ids[next_id++];
+            if (full || tracker.changed_since(id, *since))
+            {
+                response["changed"].append(to_json(object, fields));
+            }
+        }
+
+        if (!full)
+        {
+            for (auto& id : tracker.removed_since(*since))
+            {
+                response["removed"].append(id);
+            }
         }
 
         return response;
+    }
+
+    wf::ipc::method_callback list_views = [=] (wf::json_t data)
+    {
+        // The list is not copied, building the response does not free any views. Null entries for views
+        // freed by an outer for_each() are skipped by list_objects().
+        return list_objects(data, wf::tracking_allocator_t<wf::view_interface_t>::get().get_all(),
+            view_generations,
+            [] (wayfire_view view) -> uint64_t { return view->get_id(); },
+            &wf::ipc_rules::view_to_json);
     };
 
     wf::ipc::method_callback get_view_info = [=] (wf::json_t data)
@@ -239,15 +322,11 @@ class ipc_rules_t : public wf::plugin_interface_t,
         return wf::ipc::json_error("property has unsupported type");
     };
 
-    wf::ipc::method_callback list_outputs = [=] (wf::json_t)
+    wf::ipc::method_callback list_outputs = [=] (wf::json_t data)
     {
-        wf::json_t response = wf::json_t::array();
-        for (auto& output : wf::get_core().output_layout->get_outputs())
-        {
-            response.append(wf::ipc_rules::output_to_json(output));
-        }
-
-        return response;
+        return list_objects(data, wf::get_core().output_layout->get_outputs(), output_generations,
+            [] (wf::output_t *output) -> uint64_t { return output->get_id(); },
+            &wf::ipc_rules::output_to_json);
     };
 
     wf::ipc::method_callback get_output_info = [=] (wf::json_t data)
@@ -334,15 +413,14 @@ class ipc_rules_t : public wf::plugin_interface_t,
         return wf::ipc::json_ok();
     };
 
-    wf::ipc::method_callback list_wsets = [=] (wf::json_t)
+    wf::ipc::method_callback list_wsets = [=] (wf::json_t data)
     {
-        wf::json_t response = wf::json_t::array();
-        for (auto& workspace_set : wf::workspace_set_t::get_all())
+        return list_objects(data, wf::workspace_set_t::get_all(), wset_generations,
+            [] (auto wset) -> uint64_t { return wset->get_index(); },
+            [] (auto wset, const wf::ipc_rules::field_filter_t& fields)
         {
-            response.append(wf::ipc_rules::wset_to_json(workspace_set.get()));
-        }
-
-        return response;
+            return wf::ipc_rules::wset_to_json(wset.get(), fields);
+        });
     };
 
     wf::ipc::method_callback get_wset_info = [=] (wf::json_t data)
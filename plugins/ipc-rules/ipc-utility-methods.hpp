@@ -4,10 +4,15 @@
 #include "wayfire/plugins/ipc/ipc-method-repository.hpp"
 #include "wayfire/debug.hpp"
 #include "wayfire/signal-definitions.hpp"
+#include <map>
 #include <set>
 #include <wayfire/plugin.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 #include <wayfire/output-layout.hpp>
+#include <wayfire/render.hpp>
+#include <wayfire/render-manager.hpp>
+#include <wayfire/img.hpp>
+#include <wayfire/util.hpp>
 #include <wayfire/config/compound-option.hpp>
 #include <wayfire/config/config-manager.hpp>
 
@@ -24,6 +29,43 @@ class ipc_rules_utility_methods_t
     wlr_backend *headless_backend = NULL;
     std::set<uint64_t> our_outputs;
 
+    /* A capture requested over IPC, done once the output renders its next frame */
+    struct output_capture_t
+    {
+        wf::output_t *output;
+        wf::effect_hook_t on_frame;
+        // Gives up if the output does not render a frame in time
+        wf::wl_timer<false> timeout;
+    };
+
+    static constexpr uint32_t CAPTURE_TIMEOUT_MS = 1000;
+
+    std::map<wf::output_t*, std::unique_ptr<output_capture_t>> output_captures;
+    // Captures whose hook has run, destroyed once the hook has returned
+    std::vector<std::unique_ptr<output_capture_t>> finished_captures;
+    wf::wl_idle_call idle_clear_captures;
+
+    void stop_output_capture(wf::output_t *output)
+    {
+        auto it = output_captures.find(output);
+        if (it == output_captures.end())
+        {
+            return;
+        }
+
+        output->render->rem_effect(&it->second->on_frame);
+        it->second->timeout.disconnect();
+        finished_captures.push_back(std::move(it->second));
+        output_captures.erase(it);
+        idle_clear_captures.run_once([=] { finished_captures.clear(); });
+    }
+
+    wf::signal::connection_t<wf::output_pre_remove_signal> on_capture_output_removed =
+        [=] (wf::output_pre_remove_signal *ev)
+    {
+        stop_output_capture(ev->output);
+    };
+
   public:
     void init_utility_methods(ipc::method_repository_t *method_repository)
     {
@@ -35,6 +77,15 @@ class ipc_rules_utility_methods_t
         method_repository->register_method("wayfire/set-config-options", set_config_options);
         method_repository->register_method("wayfire/get-keyboard-state", get_kb_state);
         method_repository->register_method("wayfire/set-keyboard-state", set_kb_state);
+        method_repository->register_method("wayfire/plugin-load-stats", get_plugin_load_stats);
+#if WF_ALLOC_STATS
+        method_repository->register_method("wayfire/alloc-stats", get_alloc_stats);
+#endif
+        method_repository->register_method("wayfire/buffer-pool-stats", get_buffer_pool_stats);
+        method_repository->register_method("wayfire/capture-output", capture_output);
+        method_repository->register_method("wayfire/capture-stats", get_capture_stats);
+        method_repository->register_method("wayfire/restack-stats", get_restack_stats);
+        wf::get_core().output_layout->connect(&on_capture_output_removed);
     }
 
     void fini_utility_methods(ipc::method_repository_t *method_repository)
@@ -47,6 +98,21 @@ class ipc_rules_utility_methods_t
         method_repository->unregister_method("wayfire/set-config-option");
         method_repository->unregister_method("wayfire/get-keyboard-state");
         method_repository->unregister_method("wayfire/set-keyboard-state");
+        method_repository->unregister_method("wayfire/plugin-load-stats");
+#if WF_ALLOC_STATS
+        method_repository->unregister_method("wayfire/alloc-stats");
+#endif
+        method_repository->unregister_method("wayfire/buffer-pool-stats");
+        method_repository->unregister_method("wayfire/capture-output");
+        method_repository->unregister_method("wayfire/capture-stats");
+        method_repository->unregister_method("wayfire/restack-stats");
+        while (!output_captures.empty())
+        {
+            stop_output_capture(output_captures.begin()->first);
+        }
+
+        idle_clear_captures.disconnect();
+        finished_captures.clear();
     }
 
     wf::ipc::method_callback get_wayfire_configuration_info = [=] (wf::json_t)
@@ -63,6 +129,167 @@ class ipc_rules_utility_methods_t
         return response;
     };
 
+    wf::ipc::method_callback get_plugin_load_stats = [=] (wf::json_t)
+    {
+        auto response = wf::ipc::json_ok();
+        response["plugins"] = wf::json_t::array();
+        for (auto& stats : wf::get_plugin_load_stats())
+        {
+            wf::json_t entry;
+            entry["name"]    = stats.name;
+            entry["load-us"] = stats.load_us;
+            entry["init-us"] = stats.init_us;
+            response["plugins"].append(entry);
+        }
+
+        return response;
+    };
+
+    wf::ipc::method_callback get_buffer_pool_stats = [=] (const wf::json_t& data)
+    {
+        auto stats    = wf::buffer_pool_t::get().get_stats();
+        auto response = wf::ipc::json_ok();
+        response["hits"]      = (int64_t)stats.hits;
+        response["misses"]    = (int64_t)stats.misses;
+        response["evictions"] = (int64_t)stats.evictions;
+        response["buffers"]   = (int64_t)stats.buffers;
+        response["bytes"]     = (int64_t)stats.bytes;
+        if (wf::ipc::json_get_optional_bool(data, "clear").value_or(false))
+        {
+            wf::buffer_pool_t::get().clear();
+        }
+
+        return response;
+    };
+
+    wf::ipc::method_callback capture_output = [=] (const wf::json_t& data)
+    {
+        auto file   = wf::ipc::json_get_string(data, "file");
+        auto format = wf::ipc::json_get_optional_string(data, "format").value_or("png");
+        auto output = wf::ipc::json_get_optional_string(data, "output");
+        auto output_id = wf::ipc::json_get_optional_uint64(data, "output-id");
+
+        wf::output_t *wo = NULL;
+        if (output.has_value())
+        {
+            wo = wf::get_core().output_layout->find_output(output.value());
+        } else if (output_id.has_value())
+        {
+            wo = wf::ipc::find_output_by_id(output_id.value());
+        } else
+        {
+            wo = wf::get_core().seat->get_active_output();
+        }
+
+        if (!wo)
+        {
+            return wf::ipc::json_error("Output not found!");
+        }
+
+        if ((format != "png") && (format != "qoi") && (format != "raw"))
+        {
+            return wf::ipc::json_error("Unsupported format, expected png, qoi or raw!");
+        }
+
+        if (output_captures.count(wo))
+        {
+            return wf::ipc::json_error("A capture of this output is already pending!");
+        }
+
+        if (!wo->handle->enabled || wo->render->is_inhibited())
+        {
+            return wf::ipc::json_error("The output is not rendering!");
+        }
+
+        // Read the output when its next frame has been rendered, before any
+        // post effects. The whole output is damaged so that a frame is rendered.
+        auto capture = std::make_unique<output_capture_t>();
+        capture->output   = wo;
+        capture->on_frame = [=] ()
+        {
+            if (!image_io::capture_to_file(wo->render->get_target_framebuffer(), file, format))
+            {
+                LOGW("Dropped capture of output ", wo->to_string(), " to ", file);
+            }
+
+            stop_output_capture(wo);
+        };
+
+        capture->timeout.set_timeout(CAPTURE_TIMEOUT_MS, [=] ()
+        {
+            LOGW("Output ", wo->to_string(), " did not render a frame, dropped capture to ", file);
+            stop_output_capture(wo);
+        });
+
+        wo->render->add_effect(&capture->on_frame, wf::OUTPUT_EFFECT_PASS_DONE);
+        output_captures[wo] = std::move(capture);
+        wo->render->damage_whole();
+
+        return wf::ipc::json_ok();
+    };
+
+    wf::ipc::method_callback get_capture_stats = [=] (const wf::json_t&)
+    {
+        auto stats    = image_io::get_capture_stats();
+        auto response = wf::ipc::json_ok();
+        response["written"] = (int64_t)stats.written;
+        response["failed"]  = (int64_t)stats.failed;
+        response["dropped"] = (int64_t)stats.dropped;
+        response["pending"] = (int64_t)stats.pending;
+        return response;
+    };
+
+    wf::ipc::method_callback get_restack_stats = [=] (const wf::json_t&)
+    {
+        auto stats    = wf::scene::get_restack_stats();
+        auto response = wf::ipc::json_ok();
+        response["restacks"] = (int64_t)stats.restacks;
+        response["damaged-pixels"] = (int64_t)stats.damaged_pixels;
+        response["pixels-per-restack"] = stats.restacks ? (double)stats.damaged_pixels / stats.restacks : 0.0;
+        return response;
+    };
+
+#if WF_ALLOC_STATS
+    wf::ipc::method_callback get_alloc_stats = [=] (const wf::json_t& data)
+    {
+        if (!wf::alloc_stats::enabled())
+        {
+            return wf::ipc::json_error("Allocation accounting is disabled, start Wayfire with --alloc-stats");
+        }
+
+        auto max_sites = wf::ipc::json_get_optional_int64(data, "max-sites").value_or(20);
+        auto frames = wf::alloc_stats::get_frame_count();
+        auto allocations = wf::alloc_stats::get_frame_allocations();
+
+        auto response = wf::ipc::json_ok();
+        response["frames"] = (int64_t)frames;
+        response["allocations"] = (int64_t)allocations;
+        response["allocations-per-frame"] = frames ? (double)allocations / frames : 0.0;
+        response["sites"] = wf::json_t::array();
+        for (auto& site : wf::alloc_stats::get_call_sites(std::max<int64_t>(0, max_sites)))
+        {
+            wf::json_t entry;
+            entry["allocations"] = (int64_t)site.allocations;
+            entry["bytes"] = (int64_t)site.bytes;
+            entry["per-frame"] = frames ? (double)site.allocations / frames : 0.0;
+            entry["frames"] = wf::json_t::array();
+            for (auto& frame : site.frames)
+            {
+                entry["frames"].append(frame);
+            }
+
+            response["sites"].append(entry);
+        }
+
+        if (wf::ipc::json_get_optional_bool(data, "reset").value_or(false))
+        {
+            wf::alloc_stats::reset();
+        }
+
+        return response;
+    };
+#endif
+
     wf::ipc::method_callback create_headless_output = [=] (const wf::json_t& data)
     {
         auto width  = wf::ipc::json_get_uint64(data, "width");
@@ -342,6 +569,13 @@ class ipc_rules_utility_methods_t
         }
 
         reload_config_signal event;
+        event.full_reload     = false;
+        event.changed_options = data.get_member_names();
+        for (auto& option : event.changed_options)
+        {
+            event.changed_sections.insert(option.substr(0, option.find('/')));
+        }
+
         wf::get_core().emit(&event);
         return wf::ipc::json_ok();
     };
@@ -6,9 +6,12 @@
 #include "wayfire/toplevel-view.hpp"
 #include "wayfire/util.hpp"
 #include <cstring>
+#include <ctime>
+#include <map>
 #include <variant>
 #include <wayfire/output-layout.hpp>
 #include <wayfire/output.hpp>
+#include <wayfire/render-manager.hpp>
 #include <wayfire/txn/transaction-manager.hpp>
 #include <wayfire/view.hpp>
 #include <wayfire/workspace-set.hpp>
@@ -128,6 +131,82 @@ public:
   headless_input_backend_t &operator=(headless_input_backend_t &&) = delete;
 };
 
+static double timespec_diff_ms(const timespec &a, const timespec &b) {
+  return (b.tv_sec - a.tv_sec) * 1e3 + (b.tv_nsec - a.tv_nsec) / 1e6;
+}
+
+/**
+ * Records the wall-clock and CPU time spent by Wayfire for each frame painted on
+ * an output, measured from the start of the repaint (pre hooks) until the
+ * buffers have been swapped (post hooks).
+ */
+class frame_stats_probe_t {
+public:
+  std::vector<double> frame_ms;
+  std::vector<double> cpu_ms;
+  /* Only filled when Wayfire runs with --alloc-stats */
+  std::vector<int64_t> allocations;
+  int64_t frame_events = 0;
+
+  frame_stats_probe_t(wf::output_t *output)
+      : output(output), damage_start(output->render->get_damage_stats()) {
+    output->render->add_effect(&on_frame_start, OUTPUT_EFFECT_PRE);
+    output->render->add_effect(&on_frame_end, OUTPUT_EFFECT_POST);
+  }
+
+  ~frame_stats_probe_t() {
+    output->render->rem_effect(&on_frame_start);
+    output->render->rem_effect(&on_frame_end);
+  }
+
+  /* Damage counters accumulated since the probe was created */
+  wf::damage_stats_t get_damage_stats() const {
+    auto now = output->render->get_damage_stats();
+    now.frames -= damage_start.frames;
+    now.rects_before -= damage_start.rects_before;
+    now.rects_after -= damage_start.rects_after;
+    return now;
+  }
+
+  frame_stats_probe_t(const frame_stats_probe_t &) = delete;
+  frame_stats_probe_t(frame_stats_probe_t &&) = delete;
+  frame_stats_probe_t &operator=(const frame_stats_probe_t &) = delete;
+  frame_stats_probe_t &operator=(frame_stats_probe_t &&) = delete;
+
+private:
+  wf::output_t *output;
+  wf::damage_stats_t damage_start;
+  bool in_frame = false;
+  timespec wall_start, cpu_start;
+  uint64_t allocations_start = 0;
+
+  wf::effect_hook_t on_frame_start = [=]() {
+    ++frame_events;
+    in_frame = true;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+    allocations_start = wf::alloc_stats::get_frame_allocations();
+  };
+
+  wf::effect_hook_t on_frame_end = [=]() {
+    if (!in_frame) {
+      return;
+    }
+
+    timespec wall_end, cpu_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+    frame_ms.push_back(timespec_diff_ms(wall_start, wall_end));
+    cpu_ms.push_back(timespec_diff_ms(cpu_start, cpu_end));
+    if (wf::alloc_stats::enabled()) {
+      allocations.push_back(wf::alloc_stats::get_frame_allocations() -
+                            allocations_start);
+    }
+
+    in_frame = false;
+  };
+};
+
 class stipc_plugin_t : public wf::plugin_interface_t {
   wf::shared_data::ref_ptr_t<wf::ipc::method_repository_t> method_repository;
 
@@ -150,12 +229,16 @@ public:
                                        get_xwayland_pid);
     method_repository->register_method("stipc/get_xwayland_display",
                                        get_xwayland_display);
+    method_repository->register_method("stipc/frame_stats/start",
+                                       start_frame_stats);
+    method_repository->register_method("stipc/frame_stats/stop",
+                                       stop_frame_stats);
+    method_repository->register_method("stipc/color_filter", color_filter);
   }
 
   bool is_unloadable() override { return false; }
 
   ipc::method_callback layout_views = [](wf::json_t data) -> wf::json_t {
-    auto views = wf::get_core().get_all_views();
     if (!data.has_member("views") || !data["views"].is_array()) {
       return wf::ipc::json_error("Views not specified");
     }
@@ -169,16 +252,13 @@ public:
       int height = wf::ipc::json_get_int64(v, "height");
       auto output = wf::ipc::json_get_optional_string(v, "output");
 
-      auto it = std::find_if(views.begin(), views.end(), [&](auto &view) {
-        return view->get_id() == uint64_t(v["id"]);
-      });
-
-      if (it == views.end()) {
+      auto view = wf::ipc::find_view_by_id(id);
+      if (!view) {
         return wf::ipc::json_error("Could not find view with id " +
                                    std::to_string(id));
       }
 
-      auto toplevel = toplevel_cast(*it);
+      auto toplevel = toplevel_cast(view);
       if (!toplevel) {
         return wf::ipc::json_error("View is not toplevel view id " +
                                    std::to_string(id));
@@ -380,6 +460,87 @@ public:
     return response;
   };
 
+  std::map<wf::output_t *, std::unique_ptr<frame_stats_probe_t>> frame_probes;
+  wf::signal::connection_t<wf::output_removed_signal> on_output_removed =
+      [=](wf::output_removed_signal *ev) { frame_probes.erase(ev->output); };
+
+  ipc::method_callback start_frame_stats = [=](wf::json_t) {
+    frame_probes.clear();
+    for (auto &wo : wf::get_core().output_layout->get_outputs()) {
+      frame_probes[wo] = std::make_unique<frame_stats_probe_t>(wo);
+    }
+
+    wf::get_core().output_layout->connect(&on_output_removed);
+    return wf::ipc::json_ok();
+  };
+
+  ipc::method_callback stop_frame_stats = [=](wf::json_t) {
+    auto response = wf::ipc::json_ok();
+    response["outputs"] = wf::json_t::array();
+    for (auto &[wo, probe] : frame_probes) {
+      wf::json_t stats;
+      stats["output"] = wo->to_string();
+      stats["frame-events"] = probe->frame_events;
+      auto damage = probe->get_damage_stats();
+      stats["damage-frames"] = (int64_t)damage.frames;
+      stats["damage-rects-before"] = (int64_t)damage.rects_before;
+      stats["damage-rects-after"] = (int64_t)damage.rects_after;
+      stats["frame-ms"] = wf::json_t::array();
+      stats["cpu-ms"] = wf::json_t::array();
+      for (size_t i = 0; i < probe->frame_ms.size(); i++) {
+        stats["frame-ms"].append(probe->frame_ms[i]);
+        stats["cpu-ms"].append(probe->cpu_ms[i]);
+      }
+
+      if (wf::alloc_stats::enabled()) {
+        stats["allocations"] = wf::json_t::array();
+        for (auto count : probe->allocations) {
+          stats["allocations"].append(count);
+        }
+      }
+
+      response["outputs"].append(stats);
+    }
+
+    frame_probes.clear();
+    on_output_removed.disconnect();
+    return response;
+  };
+
+  /* A grayscale filter, used to benchmark the postprocessing chain */
+  wf::post_pixel_hook_t grayscale_filter{
+      "highp vec4 @name@(highp vec4 color) {\n"
+      "    highp float l = dot(color.rgb, vec3(0.2126, 0.7152, 0.0722));\n"
+      "    return vec4(vec3(l), color.a);\n"
+      "}\n",
+      {}};
+
+  ipc::method_callback color_filter = [=](wf::json_t data) {
+    auto enable = wf::ipc::json_get_bool(data, "enable");
+    auto output_id = wf::ipc::json_get_optional_int64(data, "output-id");
+
+    std::vector<wf::output_t *> outputs;
+    if (output_id.has_value()) {
+      auto wo = wf::ipc::find_output_by_id(output_id.value());
+      if (!wo) {
+        return wf::ipc::json_error("Output not found");
+      }
+
+      outputs.push_back(wo);
+    } else {
+      outputs = wf::get_core().output_layout->get_outputs();
+    }
+
+    for (auto wo : outputs) {
+      wo->render->rem_post(&grayscale_filter);
+      if (enable) {
+        wo->render->add_post(&grayscale_filter);
+      }
+    }
+
+    return wf::ipc::json_ok();
+  };
+
   std::unique_ptr<headless_input_backend_t> input;
 };
 } // namespace wf
@@ -27,15 +27,25 @@ void get_state(wayfire_view view, struct wlr_ext_foreign_toplevel_handle_v1_stat
     state->app_id = strdup(appid_buffer.c_str());
 }
 
+class wayfire_ext_foreign_toplevel;
+using ext_toplevel_queue_type = toplevel_flush_queue_t<wayfire_ext_foreign_toplevel>;
+
 class wayfire_ext_foreign_toplevel
 {
     wayfire_toplevel_view view;
     wlr_ext_foreign_toplevel_handle_v1 *handle;
+    ext_toplevel_queue_type *flush_queue;
+
+    bool dirty = false;
+    std::string last_title;
+    std::string last_app_id;
 
   public:
-    wayfire_ext_foreign_toplevel(wayfire_toplevel_view view, wlr_ext_foreign_toplevel_handle_v1 *hndl) :
+    wayfire_ext_foreign_toplevel(wayfire_toplevel_view view, wlr_ext_foreign_toplevel_handle_v1 *hndl,
+        ext_toplevel_queue_type *flush_queue) :
         view(view),
-        handle(hndl)
+        handle(hndl),
+        flush_queue(flush_queue)
     {
         /**
          * This is future-proofing.
@@ -58,10 +68,18 @@ class wayfire_ext_foreign_toplevel
 
     virtual ~wayfire_ext_foreign_toplevel()
     {
+        flush_queue->remove(this);
         disconnect_request_handlers();
         destroy_handle();
     }
 
+    /** Send the state if it changed since the last flush. */
+    void flush_state()
+    {
+        dirty = false;
+        toplevel_send_state();
+    }
+
   protected:
     virtual void init_request_handlers()
     {
@@ -93,11 +111,31 @@ class wayfire_ext_foreign_toplevel
         wlr_ext_foreign_toplevel_handle_v1_destroy(handle);
     }
 
+    void mark_dirty()
+    {
+        if (!dirty)
+        {
+            dirty = true;
+            flush_queue->push(this);
+        }
+    }
+
     virtual void toplevel_send_state()
     {
+        std::string title  = view->get_title();
+        std::string app_id = get_app_id(view);
+        if ((title == last_title) && (app_id == last_app_id))
+        {
+            return;
+        }
+
+        last_title  = title;
+        last_app_id = app_id;
+
         // Prepare the state
         struct wlr_ext_foreign_toplevel_handle_v1_state new_state;
-        get_state(view, &new_state);
+        new_state.title  = last_title.c_str();
+        new_state.app_id = last_app_id.c_str();
 
         /** Send the state; done() is sent by wlroots */
         wlr_ext_foreign_toplevel_handle_v1_update_state(handle,
@@ -106,12 +144,12 @@ class wayfire_ext_foreign_toplevel
 
     wf::signal::connection_t<wf::view_title_changed_signal> on_title_changed = [=] (auto)
     {
-        toplevel_send_state();
+        mark_dirty();
     };
 
     wf::signal::connection_t<wf::view_app_id_changed_signal> on_app_id_changed = [=] (auto)
     {
-        toplevel_send_state();
+        mark_dirty();
     };
 };
 
@@ -159,7 +197,8 @@ class wayfire_ext_foreign_toplevel_protocol_impl : public wf::plugin_interface_t
                 return;
             }
 
-            handle_for_view[toplevel] = std::make_unique<wayfire_ext_foreign_toplevel>(toplevel, handle);
+            handle_for_view[toplevel] = std::make_unique<wayfire_ext_foreign_toplevel>(toplevel, handle,
+                &flush_queue);
         }
     };
 
@@ -169,6 +208,7 @@ class wayfire_ext_foreign_toplevel_protocol_impl : public wf::plugin_interface_t
     };
 
     wlr_ext_foreign_toplevel_list_v1 *toplevel_manager;
+    ext_toplevel_queue_type flush_queue;
     std::map<wayfire_toplevel_view, std::unique_ptr<wayfire_ext_foreign_toplevel>> handle_for_view;
 };
 
@@ -16,20 +16,35 @@
 
 class wayfire_foreign_toplevel;
 using foreign_toplevel_map_type = std::map<wayfire_toplevel_view, std::unique_ptr<wayfire_foreign_toplevel>>;
+using foreign_toplevel_queue_type = toplevel_flush_queue_t<wayfire_foreign_toplevel>;
 
 class wayfire_foreign_toplevel
 {
     wayfire_toplevel_view view;
     wlr_foreign_toplevel_handle_v1 *handle;
     foreign_toplevel_map_type *view_to_toplevel;
+    foreign_toplevel_queue_type *flush_queue;
+
+    enum dirty_flags_t : uint32_t
+    {
+        DIRTY_TITLE  = (1 << 0),
+        DIRTY_APP_ID = (1 << 1),
+        DIRTY_STATE  = (1 << 2),
+        DIRTY_PARENT = (1 << 3),
+    };
+
+    uint32_t dirty = 0;
+    std::string last_title;
+    std::string last_app_id;
 
   public:
     wayfire_foreign_toplevel(wayfire_toplevel_view view, wlr_foreign_toplevel_handle_v1 *handle,
-        foreign_toplevel_map_type *view_to_toplevel)
+        foreign_toplevel_map_type *view_to_toplevel, foreign_toplevel_queue_type *flush_queue)
     {
         this->view   = view;
         this->handle = handle;
         this->view_to_toplevel = view_to_toplevel;
+        this->flush_queue = flush_queue;
 
         init_request_handlers();
         toplevel_handle_v1_close_request.connect(&handle->events.request_close);
@@ -42,6 +57,7 @@ class wayfire_foreign_toplevel
         toplevel_send_title();
         toplevel_send_app_id();
         toplevel_send_state();
+        toplevel_send_parent();
         toplevel_update_output(view->get_output(), true);
 
         view->connect(&on_title_changed);
@@ -63,22 +79,68 @@ class wayfire_foreign_toplevel
         toplevel_handle_v1_activate_request.disconnect();
         toplevel_handle_v1_fullscreen_request.disconnect();
         toplevel_handle_v1_set_rectangle_request.disconnect();
+        flush_queue->remove(this);
         wlr_foreign_toplevel_handle_v1_destroy(handle);
     }
 
+    /** Send the fields which changed since the last flush. */
+    void flush_state()
+    {
+        uint32_t flags = dirty;
+        dirty = 0;
+        if (flags & DIRTY_TITLE)
+        {
+            toplevel_send_title();
+        }
+
+        if (flags & DIRTY_APP_ID)
+        {
+            toplevel_send_app_id();
+        }
+
+        if (flags & DIRTY_STATE)
+        {
+            toplevel_send_state();
+        }
+
+        if (flags & DIRTY_PARENT)
+        {
+            toplevel_send_parent();
+        }
+    }
+
   private:
+    void mark_dirty(uint32_t flags)
+    {
+        if (!dirty)
+        {
+            flush_queue->push(this);
+        }
+
+        dirty |= flags;
+    }
+
     void toplevel_send_title()
     {
-        wlr_foreign_toplevel_handle_v1_set_title(handle, view->get_title().c_str());
+        auto title = view->get_title();
+        if (title != last_title)
+        {
+            last_title = title;
+            wlr_foreign_toplevel_handle_v1_set_title(handle, title.c_str());
+        }
     }
 
     void toplevel_send_app_id()
     {
         std::string app_id = get_app_id(view);
-
-        wlr_foreign_toplevel_handle_v1_set_app_id(handle, app_id.c_str());
+        if (app_id != last_app_id)
+        {
+            last_app_id = app_id;
+            wlr_foreign_toplevel_handle_v1_set_app_id(handle, app_id.c_str());
+        }
     }
 
+    /* wlroots sends only the state flags which actually changed. */
     void toplevel_send_state()
     {
         wlr_foreign_toplevel_handle_v1_set_maximized(handle,
@@ -86,8 +148,10 @@ class wayfire_foreign_toplevel
         wlr_foreign_toplevel_handle_v1_set_activated(handle, view->activated);
         wlr_foreign_toplevel_handle_v1_set_minimized(handle, view->minimized);
         wlr_foreign_toplevel_handle_v1_set_fullscreen(handle, view->pending_fullscreen());
+    }
 
-        /* update parent as well */
+    void toplevel_send_parent()
+    {
         auto it = view_to_toplevel->find(view->parent);
         if (it == view_to_toplevel->end())
         {
@@ -113,12 +177,12 @@ class wayfire_foreign_toplevel
 
     wf::signal::connection_t<wf::view_title_changed_signal> on_title_changed = [=] (auto)
     {
-        toplevel_send_title();
+        mark_dirty(DIRTY_TITLE);
     };
 
     wf::signal::connection_t<wf::view_app_id_changed_signal> on_app_id_changed = [=] (auto)
     {
-        toplevel_send_app_id();
+        mark_dirty(DIRTY_APP_ID);
     };
 
     wf::signal::connection_t<wf::view_set_output_signal> on_set_output = [=] (wf::view_set_output_signal *ev)
@@ -129,27 +193,27 @@ class wayfire_foreign_toplevel
 
     wf::signal::connection_t<wf::view_minimized_signal> on_minimized = [=] (auto)
     {
-        toplevel_send_state();
+        mark_dirty(DIRTY_STATE);
     };
 
     wf::signal::connection_t<wf::view_fullscreen_signal> on_fullscreen = [=] (auto)
     {
-        toplevel_send_state();
+        mark_dirty(DIRTY_STATE);
     };
 
     wf::signal::connection_t<wf::view_tiled_signal> on_tiled = [=] (auto)
     {
-        toplevel_send_state();
+        mark_dirty(DIRTY_STATE);
     };
 
     wf::signal::connection_t<wf::view_activated_state_signal> on_activated = [=] (auto)
     {
-        toplevel_send_state();
+        mark_dirty(DIRTY_STATE);
     };
 
     wf::signal::connection_t<wf::view_parent_changed_signal> on_parent_changed = [=] (auto)
     {
-        toplevel_send_state();
+        mark_dirty(DIRTY_PARENT);
     };
 
     wf::wl_listener_wrapper toplevel_handle_v1_maximize_request;
@@ -247,7 +311,7 @@ class wayfire_foreign_toplevel_protocol_impl : public wf::plugin_interface_t
         {
             auto handle = wlr_foreign_toplevel_handle_v1_create(toplevel_manager);
             handle_for_view[toplevel] =
-                std::make_unique<wayfire_foreign_toplevel>(toplevel, handle, &handle_for_view);
+                std::make_unique<wayfire_foreign_toplevel>(toplevel, handle, &handle_for_view, &flush_queue);
         }
     };
 
@@ -257,6 +321,7 @@ class wayfire_foreign_toplevel_protocol_impl : public wf::plugin_interface_t
     };
 
     wlr_foreign_toplevel_manager_v1 *toplevel_manager;
+    foreign_toplevel_queue_type flush_queue;
     std::map<wayfire_toplevel_view, std::unique_ptr<wayfire_foreign_toplevel>> handle_for_view;
 };
 
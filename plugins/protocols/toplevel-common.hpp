@@ -4,6 +4,8 @@
 #include <wayfire/nonstd/wlroots-full.hpp>
 #include <wayfire/toplevel-view.hpp>
 #include "gtk-shell.hpp"
+#include <algorithm>
+#include <vector>
 
 std::string get_app_id(wayfire_view view)
 {
@@ -45,3 +47,39 @@ std::string get_app_id(wayfire_view view)
     // Safely copy to the output buffer
     return result;
 }
+
+/**
+ * Toplevel handles whose state changed since it was last sent. Handles add
+ * themselves when they become dirty, and their state is flushed once when the
+ * event loop goes idle, so that a burst of view signals (for example a focus
+ * change across many views) results in a single update with one done event.
+ */
+template<class Handle>
+class toplevel_flush_queue_t
+{
+  public:
+    void push(Handle *handle)
+    {
+        handles.push_back(handle);
+        idle_flush.run_once([=] { flush(); });
+    }
+
+    void remove(Handle *handle)
+    {
+        handles.erase(std::remove(handles.begin(), handles.end(), handle), handles.end());
+    }
+
+  private:
+    std::vector<Handle*> handles;
+    wf::wl_idle_call idle_flush;
+
+    void flush()
+    {
+        auto dirty = std::move(handles);
+        handles.clear();
+        for (auto& handle : dirty)
+        {
+            handle->flush_state();
+        }
+    }
+};
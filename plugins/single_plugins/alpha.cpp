@@ -29,6 +29,7 @@
 #include <wayfire/output.hpp>
 #include <wayfire/output-layout.hpp>
 #include <wayfire/bindings-repository.hpp>
+#include <wayfire/nonstd/tracking-allocator.hpp>
 #include "wayfire/plugins/common/shared-core-data.hpp"
 #include "wayfire/view-helpers.hpp"
 #include "wayfire/view-transform.hpp"
@@ -148,7 +149,7 @@ class wayfire_alpha : public wf::plugin_interface_t
 
     wf::config::option_base_t::updated_callback_t min_value_changed = [=] ()
     {
-        for (auto& view : wf::get_core().get_all_views())
+        wf::tracking_allocator_t<wf::view_interface_t>::get().for_each([&] (wayfire_view view)
         {
             auto tmgr = view->get_transformed_node();
             auto transformer = tmgr->get_transformer<wf::scene::view_2d_transformer_t>("alpha");
@@ -157,15 +158,15 @@ class wayfire_alpha : public wf::plugin_interface_t
                 transformer->alpha = min_value;
                 view->damage();
             }
-        }
+        });
     };
 
     void fini() override
     {
-        for (auto& view : wf::get_core().get_all_views())
+        wf::tracking_allocator_t<wf::view_interface_t>::get().for_each([] (wayfire_view view)
         {
             view->get_transformed_node()->rem_transformer("alpha");
-        }
+        });
 
         wf::get_core().bindings->rem_binding(&axis_cb);
         ipc_repo->unregister_method("wf/alpha/set-view-alpha");
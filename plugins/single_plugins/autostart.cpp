@@ -29,7 +29,7 @@ class wayfire_autostart : public wf::plugin_interface_t
                 continue;
             }
 
-            wf::get_core().run(command);
+            wf::get_core().run_async(command);
             if (command.find("wf-panel") != std::string::npos)
             {
                 panel_manually_started = true;
@@ -43,12 +43,12 @@ class wayfire_autostart : public wf::plugin_interface_t
 
         if (autostart_wf_shell && !panel_manually_started)
         {
-            wf::get_core().run("wf-panel");
+            wf::get_core().run_async("wf-panel");
         }
 
         if (autostart_wf_shell && !background_manually_started)
         {
-            wf::get_core().run("wf-background");
+            wf::get_core().run_async("wf-background");
         }
     }
 
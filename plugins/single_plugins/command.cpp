@@ -267,7 +267,11 @@ class wayfire_command : public wf::plugin_interface_t
             for (const auto& [_, _cmd, activator] : list)
             {
                 std::string cmd     = _cmd;
-                command_callback cb = [cmd] () -> bool { return wf::get_core().run(cmd); };
+                command_callback cb = [cmd] () -> bool
+                {
+                    wf::get_core().run_async(cmd);
+                    return true;
+                };
                 bindings[i] =
                     std::bind(std::mem_fn(&wayfire_command::on_binding), this, cb, mode, always_exec, _1);
                 wf::get_core().bindings->add_activator(wf::create_option(activator), &bindings[i]);
@@ -291,9 +295,12 @@ class wayfire_command : public wf::plugin_interface_t
         bindings.clear();
     }
 
-    wf::signal::connection_t<wf::reload_config_signal> on_reload_config = [=] (auto)
+    wf::signal::connection_t<wf::reload_config_signal> on_reload_config = [=] (wf::reload_config_signal *ev)
     {
-        setup_bindings_from_config();
+        if (ev->section_changed("command"))
+        {
+            setup_bindings_from_config();
+        }
     };
 
     wf::plugin_activation_data_t grab_interface = {
@@ -379,7 +386,8 @@ class wayfire_command : public wf::plugin_interface_t
             {
                 return on_binding([js] () -> bool
                 {
-                    return wf::get_core().run(js["command"]);
+                    wf::get_core().run_async(js["command"]);
+                    return true;
                 }, mode, exec_always, data);
             };
         } else
@@ -37,6 +37,7 @@ private:
   }
 
   wf::option_wrapper_t<wf::color_t> background_color{"expo/background"};
+  wf::option_wrapper_t<std::string> background_image{"expo/background_image"};
   wf::option_wrapper_t<wf::animation_description_t> zoom_duration{
       "expo/duration"};
   wf::option_wrapper_t<int> delimiter_offset{"expo/offset"};
@@ -278,6 +279,7 @@ public:
 
   void start_zoom(bool zoom_in) {
     wall->set_background_color(background_color);
+    wall->set_background_image(background_image);
     wall->set_gap_size(this->delimiter_offset);
     if (zoom_in) {
       zoom_animation.set_start(wall->get_workspace_rectangle(
@@ -15,6 +15,8 @@
 #include <wayfire/txn/transaction-manager.hpp>
 #include <wayfire/window-manager.hpp>
 
+#include <algorithm>
+
 namespace wf
 {
 namespace tile
@@ -93,6 +95,12 @@ int32_t split_node_t::calculate_splittable() const
 }
 
 void split_node_t::recalculate_children(wf::geometry_t available, wf::txn::transaction_uptr& tx)
+{
+    layout_children(available);
+    apply_layout(tx);
+}
+
+void split_node_t::layout_children(wf::geometry_t available)
 {
     if (this->children.empty())
     {
@@ -128,7 +136,48 @@ void split_node_t::recalculate_children(wf::geometry_t available, wf::txn::trans
 
         /* Set new size */
         int32_t child_size = child_end - child_start;
-        child->set_geometry(get_child_geometry(child_start, child_size), tx);
+        child->geometry = get_child_geometry(child_start, child_size);
+        if (auto split = child->as_split_node())
+        {
+            split->layout_children(child->geometry);
+        }
+    }
+}
+
+static void collect_view_nodes(tree_node_t *node, std::vector<nonstd::observer_ptr<view_node_t>>& views)
+{
+    if (auto view = node->as_view_node())
+    {
+        views.push_back(view);
+    }
+
+    for (auto& child : node->children)
+    {
+        collect_view_nodes(child.get(), views);
+    }
+}
+
+void split_node_t::apply_layout(wf::txn::transaction_uptr& tx)
+{
+    std::vector<nonstd::observer_ptr<view_node_t>> views;
+    collect_view_nodes(this, views);
+
+    /* Crossfades are limited by a budget, so they should go to the views whose
+     * size changes the most. The others are only scaled. */
+    std::vector<std::pair<int32_t, nonstd::observer_ptr<view_node_t>>> ordered;
+    for (auto& view : views)
+    {
+        ordered.push_back({view->get_size_change(), view});
+    }
+
+    std::stable_sort(ordered.begin(), ordered.end(), [] (const auto& a, const auto& b)
+    {
+        return a.first > b.first;
+    });
+
+    for (auto& [_, view] : ordered)
+    {
+        view->apply_geometry(tx);
     }
 }
 
@@ -318,10 +367,23 @@ struct view_node_t::scale_transformer_t : public wf::scene::view_2d_transformer_
 class tile_view_animation_t : public wf::grid::grid_animation_t
 {
   public:
-    using wf::grid::grid_animation_t::grid_animation_t;
+    tile_view_animation_t(wayfire_toplevel_view view, type_t type,
+        wf::option_sptr_t<wf::animation_description_t> duration) :
+        grid_animation_t(view, type, duration)
+    {
+        if (type == CROSSFADE)
+        {
+            ++crossfades->active;
+        }
+    }
 
     ~tile_view_animation_t()
     {
+        if (type == CROSSFADE)
+        {
+            --crossfades->active;
+        }
+
         // The grid animation does this too, however, we want to remove the
         // transformer so that we can enforce the correct geometry from the
         // start.
@@ -335,6 +397,10 @@ class tile_view_animation_t : public wf::grid::grid_animation_t
     tile_view_animation_t(tile_view_animation_t &&) = delete;
     tile_view_animation_t& operator =(const tile_view_animation_t&) = delete;
     tile_view_animation_t& operator =(tile_view_animation_t&&) = delete;
+
+  private:
+    /* Keeps the counter alive while the animation runs */
+    wf::shared_data::ref_ptr_t<crossfade_counter_t> crossfades;
 };
 
 view_node_t::view_node_t(wayfire_toplevel_view view)
@@ -468,11 +534,11 @@ bool view_node_t::needs_crossfade()
 }
 
 static nonstd::observer_ptr<wf::grid::grid_animation_t> ensure_animation(
-    wayfire_toplevel_view view, wf::option_sptr_t<wf::animation_description_t> duration)
+    wayfire_toplevel_view view, wf::grid::grid_animation_t::type_t type,
+    wf::option_sptr_t<wf::animation_description_t> duration)
 {
     if (!view->has_data<wf::grid::grid_animation_t>())
     {
-        const auto type = wf::grid::grid_animation_t::CROSSFADE;
         view->store_data<wf::grid::grid_animation_t>(
             std::make_unique<tile_view_animation_t>(view, type, duration));
     }
@@ -483,7 +549,23 @@ static nonstd::observer_ptr<wf::grid::grid_animation_t> ensure_animation(
 void view_node_t::set_geometry(wf::geometry_t geometry, wf::txn::transaction_uptr& tx)
 {
     tree_node_t::set_geometry(geometry, tx);
+    apply_geometry(tx);
+}
 
+int32_t view_node_t::get_size_change()
+{
+    if (!view->is_mapped())
+    {
+        return 0;
+    }
+
+    auto target  = calculate_target_geometry();
+    auto current = view->get_geometry();
+    return std::abs(target.width - current.width) + std::abs(target.height - current.height);
+}
+
+void view_node_t::apply_geometry(wf::txn::transaction_uptr& tx)
+{
     if (!view->is_mapped())
     {
         return;
@@ -493,11 +575,20 @@ void view_node_t::set_geometry(wf::geometry_t geometry, wf::txn::transaction_upt
     view->toplevel()->pending().tiled_edges = TILED_EDGES_ALL;
     tx->add_object(view->toplevel());
 
-    auto target = calculate_target_geometry();
-    if (this->needs_crossfade() && (target != view->get_geometry()))
+    auto target  = calculate_target_geometry();
+    auto current = view->get_geometry();
+    if (this->needs_crossfade() && (target != current))
     {
+        /* A crossfade needs a buffer with the old contents of the view, which
+         * is pointless if the view only moves. */
+        auto type = wf::grid::grid_animation_t::TRANSFORM;
+        if ((wf::dimensions(target) != wf::dimensions(current)) && (crossfades->active < crossfade_budget))
+        {
+            type = wf::grid::grid_animation_t::CROSSFADE;
+        }
+
         view->get_transformed_node()->rem_transformer(scale_transformer_name);
-        ensure_animation(view, animation_duration)
+        ensure_animation(view, type, animation_duration)
         ->adjust_target_geometry(target, -1, tx);
     } else
     {
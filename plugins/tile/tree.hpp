@@ -7,6 +7,7 @@
 #include <wayfire/view.hpp>
 #include <wayfire/option-wrapper.hpp>
 #include <wayfire/txn/transaction.hpp>
+#include <wayfire/plugins/common/shared-core-data.hpp>
 
 namespace wf
 {
@@ -129,6 +130,17 @@ struct split_node_t : public tree_node_t
      */
     void recalculate_children(wf::geometry_t available_geometry, wf::txn::transaction_uptr& tx);
 
+    /**
+     * Calculate the geometry of all nodes in the subtree, without applying it
+     * to the views yet.
+     */
+    void layout_children(wf::geometry_t available_geometry);
+
+    /**
+     * Apply the geometry of all view nodes in the subtree to their views.
+     */
+    void apply_layout(wf::txn::transaction_uptr& tx);
+
     /**
      * Calculate the geometry of a child if it has child_size as one
      * dimension. Whether this is width/height depends on the node split type.
@@ -150,6 +162,12 @@ struct split_node_t : public tree_node_t
 struct tile_adjust_transformer_signal
 {};
 
+/** The number of tiled views which are currently animated with a crossfade. */
+struct crossfade_counter_t
+{
+    int active = 0;
+};
+
 /**
  * Represents a leaf in the tree, contains a single view
  */
@@ -169,6 +187,22 @@ struct view_node_t : public tree_node_t
      */
     void set_geometry(wf::geometry_t geometry, wf::txn::transaction_uptr& tx) override;
 
+    /**
+     * Apply the current geometry of the node to the view.
+     *
+     * If the size of the view changes, it is animated with a crossfade as long
+     * as the crossfade budget (simple-tile/crossfade_budget) allows it,
+     * otherwise the view is just scaled during the animation. Views which only
+     * move are never crossfaded.
+     */
+    void apply_geometry(wf::txn::transaction_uptr& tx);
+
+    /**
+     * @return How much the size of the view changes when the geometry of the
+     *   node is applied, as the sum of the width and height differences.
+     */
+    int32_t get_size_change();
+
     /**
      * When true, the view will occupy the entire workarea (minus gaps),
      */
@@ -193,6 +227,8 @@ struct view_node_t : public tree_node_t
     wf::option_wrapper_t<wf::animation_description_t> animation_duration{"simple-tile/animation_duration"};
     wf::option_wrapper_t<int> outer_horiz_gaps{"simple-tile/outer_horiz_gap_size"};
     wf::option_wrapper_t<int> outer_vert_gaps{"simple-tile/outer_vert_gap_size"};
+    wf::option_wrapper_t<int> crossfade_budget{"simple-tile/crossfade_budget"};
+    wf::shared_data::ref_ptr_t<crossfade_counter_t> crossfades;
 
     /**
      * Check whether the crossfade animation should be enabled for the view
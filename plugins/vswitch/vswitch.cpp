@@ -10,6 +10,9 @@
 #include "wayfire/unstable/translation-node.hpp"
 #include "wayfire/scene-operations.hpp"
 #include "wayfire/render-manager.hpp"
+#include "wayfire/workspace-stream.hpp"
+
+#include <map>
 
 namespace wf
 {
@@ -101,6 +104,162 @@ class vswitch_overlay_node_t : public wf::scene::node_t
     }
 };
 
+/**
+ * A scenegraph node which shows the workspaces of an output side by side, as if they were one big
+ * surface, and renders the part of them visible in a viewport directly on the output.
+ *
+ * In contrast to the workspace wall, the workspaces are not rendered to auxiliary buffers first,
+ * they are just translated, so views on them can still be occluded by other views.
+ */
+class workspace_slide_node_t : public wf::scene::floating_inner_node_t
+{
+    class slide_render_instance_t : public scene::render_instance_t
+    {
+        workspace_slide_node_t *self;
+        std::vector<scene::render_instance_uptr> children;
+
+      public:
+        slide_render_instance_t(workspace_slide_node_t *self, scene::damage_callback push_damage)
+        {
+            this->self = self;
+            for (auto& ch : self->get_children())
+            {
+                ch->gen_render_instances(children, push_damage, self->output);
+            }
+        }
+
+        void schedule_instructions(std::vector<scene::render_instruction_t>& instructions,
+            const wf::render_target_t& target, wf::region_t& damage) override
+        {
+            for (auto& ch : children)
+            {
+                ch->schedule_instructions(instructions, target, damage);
+            }
+
+            // Clear what is left, for example outside of the workspace grid, so that nothing below us
+            // is repainted.
+            auto bbox = self->get_bounding_box();
+            wf::region_t our_damage = damage & bbox;
+            if (!our_damage.empty())
+            {
+                instructions.push_back(scene::render_instruction_t{
+                        .instance = this,
+                        .target   = target,
+                        .damage   = our_damage,
+                    });
+                damage ^= bbox;
+            }
+        }
+
+        void render(const wf::scene::render_instruction_t& data) override
+        {
+            data.pass->clear(data.damage, self->background);
+        }
+
+        void presentation_feedback(wf::output_t *output) override
+        {
+            for (auto& ch : children)
+            {
+                ch->presentation_feedback(output);
+            }
+        }
+
+        void compute_visibility(wf::output_t *output, wf::region_t& visible) override
+        {
+            for (auto& ch : children)
+            {
+                ch->compute_visibility(output, visible);
+            }
+        }
+    };
+
+  public:
+    workspace_slide_node_t(wf::output_t *output, wf::color_t background) : floating_inner_node_t(false)
+    {
+        this->output     = output;
+        this->background = background;
+    }
+
+    /**
+     * Set which part of the workspace grid is shown on the output. A workspace (i, j) occupies the
+     * rectangle {i * W, j * H, W, H}, where WxH is the size of the output.
+     *
+     * Only the workspaces which intersect the viewport have nodes, usually the source and the target
+     * workspace of the switch.
+     */
+    void set_viewport(const wf::geometry_t& viewport)
+    {
+        auto size   = output->get_screen_size();
+        auto origin = wf::origin(output->get_layout_geometry());
+        auto [w, h] = output->wset()->get_workspace_grid_size();
+
+        std::map<std::pair<int, int>, std::shared_ptr<scene::translation_node_t>> visible;
+        std::vector<scene::node_ptr> children;
+        for (int i = 0; i < w; i++)
+        {
+            for (int j = 0; j < h; j++)
+            {
+                wf::geometry_t rect = {i * size.width, j * size.height, size.width, size.height};
+                if (!(rect & viewport))
+                {
+                    continue;
+                }
+
+                auto& translation = visible[{i, j}];
+                auto it = workspaces.find({i, j});
+                if (it != workspaces.end())
+                {
+                    translation = it->second;
+                } else
+                {
+                    auto stream = std::make_shared<workspace_stream_node_t>(output, wf::point_t{i, j});
+                    translation = std::make_shared<scene::translation_node_t>();
+                    translation->set_children_list({stream});
+                }
+
+                translation->set_offset(origin + wf::point_t{rect.x - viewport.x, rect.y - viewport.y});
+                children.push_back(translation);
+            }
+        }
+
+        if (visible != workspaces)
+        {
+            workspaces = std::move(visible);
+            set_children_list(children);
+            scene::update(shared_from_this(), scene::update_flag::CHILDREN_LIST);
+        }
+
+        scene::damage_node(shared_from_this(), get_bounding_box());
+    }
+
+    void gen_render_instances(std::vector<scene::render_instance_uptr>& instances,
+        scene::damage_callback push_damage, wf::output_t *shown_on) override
+    {
+        if (shown_on != this->output)
+        {
+            return;
+        }
+
+        instances.push_back(std::make_unique<slide_render_instance_t>(this, push_damage));
+    }
+
+    std::string stringify() const override
+    {
+        return "vswitch-slide " + stringify_flags();
+    }
+
+    wf::geometry_t get_bounding_box() override
+    {
+        return output->get_layout_geometry();
+    }
+
+  private:
+    wf::output_t *output;
+    wf::color_t background;
+    // The workspaces currently intersecting the viewport
+    std::map<std::pair<int, int>, std::shared_ptr<scene::translation_node_t>> workspaces;
+};
+
 /**
  * Represents the action of switching workspaces with the vswitch algorithm.
  *
@@ -132,10 +291,18 @@ class workspace_switch_t
     {
         /* Setup wall */
         wall->set_gap_size(gap);
-        wall->set_viewport(wall->get_workspace_rectangle(
-            output->wset()->get_current_workspace()));
-        wall->set_background_color(background_color);
-        wall->start_output_renderer();
+        auto viewport = wall->get_workspace_rectangle(output->wset()->get_current_workspace());
+        if (needs_wall())
+        {
+            wall->set_viewport(viewport);
+            wall->set_background_color(background_color);
+            wall->start_output_renderer();
+        } else
+        {
+            slide_node = std::make_shared<workspace_slide_node_t>(output, background_color);
+            slide_node->set_viewport(viewport);
+            wf::scene::add_front(wf::get_core().scene(), slide_node);
+        }
 
         if (overlay_view_node)
         {
@@ -247,7 +414,15 @@ class workspace_switch_t
             adjust_overlay_view_switch_done(old_ws);
         }
 
-        wall->stop_output_renderer(true);
+        if (slide_node)
+        {
+            wf::scene::remove_child(slide_node);
+            slide_node.reset();
+        } else
+        {
+            wall->stop_output_renderer(true);
+        }
+
         output->render->rem_effect(&post_render);
         running = false;
     }
@@ -263,10 +438,25 @@ class workspace_switch_t
   protected:
     option_wrapper_t<int> gap{"vswitch/gap"};
     option_wrapper_t<color_t> background_color{"vswitch/background"};
+    option_wrapper_t<bool> direct_render{"vswitch/direct_render"};
     workspace_animation_t animation;
 
     output_t *output;
     std::unique_ptr<workspace_wall_t> wall;
+    // Used instead of the wall when the workspaces are only translated
+    std::shared_ptr<workspace_slide_node_t> slide_node;
+
+    /**
+     * Whether the animation needs to be rendered with the workspace wall, for
+     * example to show gaps between the workspaces. Otherwise, the workspaces are
+     * rendered directly on the output, without auxiliary buffers.
+     *
+     * Subclasses which dim or zoom the workspaces should return true.
+     */
+    virtual bool needs_wall()
+    {
+        return !direct_render || (gap != 0);
+    }
 
     const std::string vswitch_view_transformer_name = "vswitch-transformer";
     wayfire_toplevel_view overlay_view;
@@ -316,7 +506,14 @@ class workspace_switch_t
             start.width,
             start.height,
         };
-        wall->set_viewport(viewport);
+        if (slide_node)
+        {
+            slide_node->set_viewport(viewport);
+        } else
+        {
+            wall->set_viewport(viewport);
+        }
+
         update_overlay_fb();
 
         output->render->damage_whole();
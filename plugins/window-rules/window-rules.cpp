@@ -58,7 +58,10 @@ class wayfire_window_rules_t : public wf::per_output_plugin_instance_t
     // Auto-reload on changes to config file
     wf::signal::connection_t<wf::reload_config_signal> _reload_config = [=] (wf::reload_config_signal *ev)
     {
-        setup_rules_from_config();
+        if (ev->section_changed("window-rules"))
+        {
+            setup_rules_from_config();
+        }
     };
 
     std::vector<std::shared_ptr<wf::rule_t>> _rules;
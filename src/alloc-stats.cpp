@@ -0,0 +1,299 @@
+#include "main.hpp"
+#include <config.h>
+#include <wayfire/debug.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <dlfcn.h>
+
+#if WF_ALLOC_STATS
+
+#if __has_include(<execinfo.h>)
+    #include <execinfo.h>
+    #include <cxxabi.h>
+    #define WF_ALLOC_STATS_HAS_BACKTRACE 1
+#else
+    #define WF_ALLOC_STATS_HAS_BACKTRACE 0
+#endif
+
+/*
+ * With the alloc_stats build option, operator new is replaced for the whole
+ * process, so that allocations can be counted. The replacement costs a single
+ * relaxed load when accounting is disabled at runtime. Without the option, the
+ * functions below are stubs and the default operator new is used.
+ *
+ * Call sites are stored in a fixed-size open-addressing table, because we
+ * cannot allocate while recording an allocation.
+ */
+namespace
+{
+/* Number of stack frames stored per call site, excluding operator new. */
+constexpr int SITE_DEPTH = 4;
+constexpr size_t MAX_SITES = 4096;
+
+struct site_entry_t
+{
+    /* 0 marks a free slot */
+    uint64_t key = 0;
+    void *frames[SITE_DEPTH] = {};
+    int nr_frames = 0;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+std::atomic<bool> accounting_enabled{false};
+site_entry_t sites[MAX_SITES];
+uint64_t frame_allocations = 0;
+uint64_t frame_count = 0;
+
+/* Only the thread which repaints outputs enters frames, so allocations from
+ * worker threads are never accounted. */
+thread_local int frame_depth = 0;
+thread_local bool recording   = false;
+
+__attribute__((always_inline)) inline void record_allocation(size_t size)
+{
+    if (!accounting_enabled.load(std::memory_order_relaxed) || !frame_depth || recording)
+    {
+        return;
+    }
+
+    recording = true;
+    ++frame_allocations;
+
+    void *trace[SITE_DEPTH + 1] = {};
+    int depth = 0;
+#if WF_ALLOC_STATS_HAS_BACKTRACE
+    // Frame 0 is operator new itself.
+    depth = backtrace(trace, SITE_DEPTH + 1);
+#endif
+
+    // FNV-1a over the return addresses
+    uint64_t key = 14695981039346656037ull;
+    for (int i = 1; i < depth; i++)
+    {
+        key = (key ^ (uintptr_t)trace[i]) * 1099511628211ull;
+    }
+
+    key |= 1;
+    for (size_t probe = 0; probe < MAX_SITES; probe++)
+    {
+        auto& entry = sites[(key + probe) % MAX_SITES];
+        if (entry.key == 0)
+        {
+            entry.key = key;
+            entry.nr_frames = std::max(0, depth - 1);
+            std::copy(trace + 1, trace + 1 + entry.nr_frames, entry.frames);
+        }
+
+        if (entry.key == key)
+        {
+            entry.allocations++;
+            entry.bytes += size;
+            break;
+        }
+    }
+
+    recording = false;
+}
+
+__attribute__((always_inline)) inline void *allocate(size_t size)
+{
+    record_allocation(size);
+    while (true)
+    {
+        if (void *ptr = std::malloc(size ? size : 1))
+        {
+            return ptr;
+        }
+
+        auto handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+
+        handler();
+    }
+}
+
+std::string describe_frame(void *address)
+{
+    Dl_info info;
+    if (dladdr(address, &info) && info.dli_sname)
+    {
+#if WF_ALLOC_STATS_HAS_BACKTRACE
+        int status;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+        if (status == 0)
+        {
+            std::string name = demangled;
+            free(demangled);
+            return name;
+        }
+
+        free(demangled);
+#endif
+        return info.dli_sname;
+    }
+
+    std::ostringstream out;
+    out << address;
+    if (info.dli_fname)
+    {
+        out << " in " << info.dli_fname;
+    }
+
+    return out.str();
+}
+}
+
+void*operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void*operator new[](size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+bool wf::alloc_stats::enable()
+{
+#if WF_ALLOC_STATS_HAS_BACKTRACE
+    // The first backtrace() call loads libgcc, do it outside of operator new.
+    void *trace[1];
+    backtrace(trace, 1);
+#endif
+    accounting_enabled = true;
+    return true;
+}
+
+void wf::alloc_stats::begin_frame()
+{
+    ++frame_depth;
+}
+
+void wf::alloc_stats::end_frame()
+{
+    if (--frame_depth == 0)
+    {
+        ++frame_count;
+    }
+}
+
+bool wf::alloc_stats::enabled()
+{
+    return accounting_enabled;
+}
+
+uint64_t wf::alloc_stats::get_frame_allocations()
+{
+    return frame_allocations;
+}
+
+uint64_t wf::alloc_stats::get_frame_count()
+{
+    return accounting_enabled ? frame_count : 0;
+}
+
+std::vector<wf::alloc_stats::call_site_t> wf::alloc_stats::get_call_sites(size_t max_sites)
+{
+    std::vector<const site_entry_t*> used;
+    for (auto& entry : sites)
+    {
+        if (entry.key != 0)
+        {
+            used.push_back(&entry);
+        }
+    }
+
+    std::sort(used.begin(), used.end(), [] (const site_entry_t *a, const site_entry_t *b)
+    {
+        return a->allocations > b->allocations;
+    });
+
+    std::vector<call_site_t> result;
+    for (size_t i = 0; i < std::min(max_sites, used.size()); i++)
+    {
+        call_site_t site;
+        site.allocations = used[i]->allocations;
+        site.bytes = used[i]->bytes;
+        for (int j = 0; j < used[i]->nr_frames; j++)
+        {
+            site.frames.push_back(describe_frame(used[i]->frames[j]));
+        }
+
+        result.push_back(std::move(site));
+    }
+
+    return result;
+}
+
+void wf::alloc_stats::reset()
+{
+    std::fill(std::begin(sites), std::end(sites), site_entry_t{});
+    frame_allocations = 0;
+    frame_count = 0;
+}
+
+#else
+
+bool wf::alloc_stats::enable()
+{
+    return false;
+}
+
+void wf::alloc_stats::begin_frame()
+{}
+
+void wf::alloc_stats::end_frame()
+{}
+
+bool wf::alloc_stats::enabled()
+{
+    return false;
+}
+
+uint64_t wf::alloc_stats::get_frame_allocations()
+{
+    return 0;
+}
+
+uint64_t wf::alloc_stats::get_frame_count()
+{
+    return 0;
+}
+
+std::vector<wf::alloc_stats::call_site_t> wf::alloc_stats::get_call_sites(size_t max_sites)
+{
+    return {};
+}
+
+void wf::alloc_stats::reset()
+{}
+
+#endif
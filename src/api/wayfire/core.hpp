@@ -6,6 +6,7 @@
 #include <wayfire/scene.hpp>
 #include <wayfire/signal-provider.hpp>
 
+#include <functional>
 #include <limits>
 #include <sys/types.h>
 #include <vector>
@@ -261,7 +262,8 @@ public:
   virtual wlr_cursor *get_wlr_cursor() = 0;
 
   /**
-   * @deprecated. Use tracking_allocator_t<view_interface_t>::get_all()
+   * @deprecated. Copies the list of views on every call, use
+   * tracking_allocator_t<view_interface_t>::get_all() or for_each() instead.
    *
    * @return A list of all views core manages, regardless of their output,
    *  properties, etc.
@@ -285,10 +287,21 @@ public:
    * This also sets some environment variables for the new process, including
    * correct WAYLAND_DISPLAY and DISPLAY.
    *
-   * @return The PID of the started client, or -1 on failure.
+   * @return The PID of the started client, or 0 on failure.
    */
   virtual pid_t run(std::string command) = 0;
 
+  /**
+   * Same as run(), but does not wait for the process to be started, so that
+   * it can be used from key bindings without delaying frames.
+   *
+   * @param callback Called with the PID of the started client, or 0 on
+   *   failure. It is usually called from the event loop later, but may be
+   *   called before run_async() returns.
+   */
+  virtual void run_async(std::string command,
+                         std::function<void(pid_t)> callback = {}) = 0;
+
   /**
    * @return The current state of the compositor.
    */
@@ -15,6 +15,8 @@
 #include <wayfire/scene.hpp>
 #include <wayfire/core.hpp>
 #include <bitset>
+#include <string>
+#include <vector>
 
 namespace wf
 {
@@ -74,6 +76,43 @@ enum class logging_category : size_t
 
 extern std::bitset<(size_t)logging_category::TOTAL> enabled_categories;
 }
+
+/**
+ * Heap allocation accounting for the render loop.
+ *
+ * When Wayfire is built with the alloc_stats option and started with --alloc-stats, every heap
+ * allocation done with operator new while an output is being repainted is counted and attributed to its
+ * call site. This lets plugin authors see what their effect hooks and render instances cost per frame.
+ * When disabled, all counters stay at zero.
+ */
+namespace alloc_stats
+{
+struct call_site_t
+{
+    /** The innermost stack frames of the call site, as demangled symbol names. */
+    std::vector<std::string> frames;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+/** Whether allocation accounting is enabled. */
+bool enabled();
+
+/** The total number of allocations made while repainting outputs. */
+uint64_t get_frame_allocations();
+
+/** The number of frames which have been accounted. */
+uint64_t get_frame_count();
+
+/**
+ * Get the call sites which allocated the most during frames, sorted by number of allocations.
+ * @param max_sites The maximal number of call sites to return.
+ */
+std::vector<call_site_t> get_call_sites(size_t max_sites);
+
+/** Reset all counters. */
+void reset();
+}
 }
 
 #define LOGC(CAT, ...) \
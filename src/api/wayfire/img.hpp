@@ -2,23 +2,134 @@
 #define IMG_HPP_
 
 #include <wayfire/opengl.hpp>
+#include <wayfire/geometry.hpp>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace image_io
 {
+/** An image decoded into memory, with 8 bits per channel and tightly packed rows. */
+struct decoded_image_t
+{
+    int width    = 0;
+    int height   = 0;
+    /* 3 for RGB, 4 for RGBA */
+    int channels = 4;
+    std::vector<uint8_t> data;
+};
+
 /* Load the image from the given file, binding it to the given GL texture target
  * Bind the texture before you call this function
  * Guaranteed: doesn't change any GL state except pixel packing */
 bool load_from_file(std::string name, GLuint target);
 
+/**
+ * Decode the given file into memory, without touching any GL state. Safe to
+ * call from any thread.
+ *
+ * @param target_size If not empty, the image is scaled to this size.
+ */
+bool decode_file(const std::string& name, decoded_image_t& image,
+    wf::dimensions_t target_size = {0, 0});
+
+/**
+ * Scale the image to the given size. Shrinking averages all source pixels
+ * covered by each destination pixel, growing interpolates bilinearly.
+ * Nothing happens if the size is empty.
+ */
+void scale_image(decoded_image_t& image, wf::dimensions_t size);
+
+/**
+ * Upload a decoded image to the given GL texture target (GL_TEXTURE_2D or
+ * GL_TEXTURE_CUBE_MAP). The same rules as for load_from_file() apply.
+ */
+bool upload_to_texture(const decoded_image_t& image, GLuint target);
+
+/**
+ * A handle to an image which is being decoded in the background.
+ * Destroying the handle cancels the load, its callback is then never called.
+ */
+class async_load_t
+{
+  public:
+    struct request_t;
+    explicit async_load_t(std::shared_ptr<request_t> request);
+    ~async_load_t();
+
+    async_load_t(const async_load_t&) = delete;
+    async_load_t& operator =(const async_load_t&) = delete;
+
+    /** @return Whether the callback has not been called yet. */
+    bool pending() const;
+
+  private:
+    std::shared_ptr<request_t> request;
+};
+
+/* Called with the decoded image, or with nullptr if decoding failed */
+using load_callback_t = std::function<void (std::shared_ptr<decoded_image_t> image)>;
+
+/**
+ * Decode the file on a worker thread, then call @callback on the main loop.
+ * Plugins can bind their texture and call upload_to_texture() from the
+ * callback, so that only the upload happens on the compositor thread.
+ *
+ * If core/image_cache_dir is set, decoded images are also stored there, keyed
+ * by the path, modification time and target size of the image, so that the
+ * next load of the same image does not need to decode it again.
+ *
+ * @param target_size If not empty, the image is scaled to this size.
+ */
+std::unique_ptr<async_load_t> load_from_file_async(std::string name,
+    wf::dimensions_t target_size, load_callback_t callback);
+
 /* Function that saves the given pixels(in rgba format) to a (currently) png file */
 void write_to_file(std::string name, uint8_t *pixels, int w, int h,
     std::string type, bool invert = false);
 
+/* Read back the buffer and save it as a png file. Blocks until the GPU has
+ * finished rendering to the buffer, see capture_to_file() for an alternative. */
 void write_to_file(std::string name, const wf::render_buffer_t& buffer);
 
+/* Called on the main loop once a capture has been written, @ok indicates
+ * whether writing the file succeeded */
+using capture_callback_t = std::function<void (bool ok)>;
+
+/**
+ * Save the current contents of the buffer to a file without stalling the
+ * compositor. With the GLES renderer, the pixels are copied to a pixel buffer
+ * object and only mapped once the GPU is done, with other renderers they are
+ * read back immediately. Encoding happens on a worker thread.
+ *
+ * At most core/capture_queue_size captures are in progress at the same time,
+ * further captures are dropped until one of them is finished.
+ *
+ * @param type The file format, one of "png", "qoi" or "raw" (RGBA pixels
+ *   without a header). QOI is much faster to encode than PNG.
+ * @return false if the capture was dropped or the format is not supported.
+ */
+bool capture_to_file(const wf::render_buffer_t& buffer, std::string name,
+    std::string type, capture_callback_t callback = {});
+
+/* Counters for capture_to_file(), since startup */
+struct capture_stats_t
+{
+    uint64_t written = 0;
+    uint64_t failed  = 0;
+    uint64_t dropped = 0;
+    /* Captures which are currently being read back or encoded */
+    size_t pending   = 0;
+};
+
+capture_stats_t get_capture_stats();
+
 /* Initializes all backends, called at startup */
 void init();
+
+/* Stops the decoding threads, called at shutdown */
+void fini();
 }
 
 #endif /* end of include guard: IMG_HPP_ */
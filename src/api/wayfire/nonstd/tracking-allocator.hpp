@@ -2,7 +2,9 @@
 #include <memory>
 #include <functional>
 #include <algorithm>
+#include <unordered_map>
 #include <wayfire/dassert.hpp>
+#include <wayfire/object.hpp>
 #include <wayfire/nonstd/observer_ptr.h>
 #include <wayfire/signal-provider.hpp>
 
@@ -22,6 +24,9 @@ struct destruct_signal
  * The tracking allocator is a factory singleton for allocating objects of a certain type.
  * The objects are allocated via shared pointers, and the tracking allocator keeps a list of all allocated
  * objects, accessible by plugins.
+ *
+ * Objects derived from object_base_t are additionally indexed by their id, so that they can be looked up
+ * without scanning the whole list.
  */
 template<class ObjectType>
 class tracking_allocator_t
@@ -44,17 +49,96 @@ class tracking_allocator_t
             new ConcreteObjectType(std::forward<Args>(args)...),
             std::bind(&tracking_allocator_t<ObjectType>::deallocate_object, this, std::placeholders::_1));
 
+        if (!nr_iterating && (nr_freed > allocated_objects.size() / 2))
+        {
+            compact();
+        }
+
+        positions[ptr.get()] = allocated_objects.size();
         allocated_objects.push_back(ptr.get());
+        if constexpr (std::is_base_of_v<wf::object_base_t, ObjectType>)
+        {
+            objects_by_id[ptr->get_id()] = ptr.get();
+        }
+
         return ptr;
     }
 
+    /**
+     * Get all allocated objects, in the order they were allocated.
+     *
+     * The list is not copied. Objects freed while iterating over it are replaced by null entries until the
+     * next call to get_all(), and allocating objects may reallocate the list. Code which may free or
+     * allocate objects while iterating should use for_each() instead.
+     *
+     * While a for_each() is in progress, the list is not compacted, so it may contain null entries for
+     * objects freed during that iteration. Code which may run from a for_each() callback has to skip them.
+     */
     const std::vector<nonstd::observer_ptr<ObjectType>>& get_all()
     {
+        if (!nr_iterating && (nr_freed > 0))
+        {
+            compact();
+        }
+
         return allocated_objects;
     }
 
+    /**
+     * Call @callback for each allocated object, in the order they were allocated, without copying the list.
+     *
+     * The callback may free and allocate objects. Objects freed before they are visited are skipped, and
+     * objects allocated during the iteration are not visited.
+     */
+    template<class Callback>
+    void for_each(Callback&& callback)
+    {
+        // Compacting the list would move the entries which are not visited yet, so it is postponed until
+        // the outermost iteration is done.
+        struct iteration_guard_t
+        {
+            size_t& counter;
+            ~iteration_guard_t()
+            {
+                --counter;
+            }
+        };
+
+        ++nr_iterating;
+        iteration_guard_t guard{nr_iterating};
+        const size_t end = allocated_objects.size();
+        for (size_t i = 0; i < end; i++)
+        {
+            if (auto object = allocated_objects[i])
+            {
+                callback(object);
+            }
+        }
+    }
+
+    /**
+     * Find an allocated object by its id (see object_base_t::get_id()).
+     *
+     * @return The object, or nullptr if no object with the given id is allocated.
+     */
+    nonstd::observer_ptr<ObjectType> find_by_id(uint32_t id) const
+    {
+        static_assert(std::is_base_of_v<wf::object_base_t, ObjectType>,
+            "Only objects derived from object_base_t have an id!");
+        auto it = objects_by_id.find(id);
+        return it == objects_by_id.end() ? nullptr : it->second;
+    }
+
   private:
     std::vector<nonstd::observer_ptr<ObjectType>> allocated_objects;
+    // The index of each object in allocated_objects.
+    std::unordered_map<ObjectType*, size_t> positions;
+    std::unordered_map<uint32_t, ObjectType*> objects_by_id;
+    // The number of null entries in allocated_objects, removed lazily by compact().
+    size_t nr_freed = 0;
+    // The number of for_each() calls in progress.
+    size_t nr_iterating = 0;
+
     void deallocate_object(ObjectType *obj)
     {
         if constexpr (std::is_base_of_v<wf::signal::provider_t, ObjectType>)
@@ -64,11 +148,34 @@ class tracking_allocator_t
             obj->emit(&event);
         }
 
-        auto it = std::find(allocated_objects.begin(), allocated_objects.end(),
-            nonstd::observer_ptr<ObjectType>{obj});
-        wf::dassert(it != allocated_objects.end(), "Object is not allocated?");
-        allocated_objects.erase(it);
+        auto it = positions.find(obj);
+        wf::dassert(it != positions.end(), "Object is not allocated?");
+        allocated_objects[it->second] = nullptr;
+        positions.erase(it);
+        ++nr_freed;
+
+        if constexpr (std::is_base_of_v<wf::object_base_t, ObjectType>)
+        {
+            objects_by_id.erase(obj->get_id());
+        }
+
         delete obj;
     }
+
+    void compact()
+    {
+        size_t next = 0;
+        for (size_t i = 0; i < allocated_objects.size(); i++)
+        {
+            if (allocated_objects[i])
+            {
+                positions[allocated_objects[i].get()] = next;
+                allocated_objects[next++] = allocated_objects[i];
+            }
+        }
+
+        allocated_objects.resize(next);
+        nr_freed = 0;
+    }
 };
 }
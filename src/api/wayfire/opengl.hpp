@@ -222,6 +222,38 @@ void render_texture(wf::gles_texture_t texture,
     glm::vec4 color = glm::vec4(1.f),
     uint32_t bits   = 0);
 
+/**
+ * A quad in a batch of textured quads.
+ */
+struct textured_quad_t
+{
+    /** The coordinates of the quad, before applying the transform. */
+    gl_geometry geometry;
+    /**
+     * The part of the texture shown on the quad, in texture coordinates, see
+     * render_transformed_texture(). Used only with TEXTURE_USE_TEX_GEOMETRY.
+     */
+    gl_geometry texture_geometry;
+};
+
+/**
+ * Render multiple quads from the same texture with a single draw call, using
+ * the built-in shaders. The program, texture and uniforms are set up only once
+ * for all quads.
+ *
+ * @param texture   The texture to render.
+ * @param quads     The quads to render.
+ * @param transform The matrix transformation to apply to all quads.
+ * @param color     A color multiplier for each channel of the texture.
+ * @param bits      A bitwise OR of texture_rendering_flags_t, except
+ *                    RENDER_FLAG_CACHED which is ignored.
+ */
+void render_textured_quads(wf::gles_texture_t texture,
+    const std::vector<textured_quad_t>& quads,
+    glm::mat4 transform = glm::mat4(1.0),
+    glm::vec4 color     = glm::vec4(1.f),
+    uint32_t bits = 0);
+
 /**
  * Render the textured rectangle again.
  *
@@ -256,6 +288,29 @@ GLuint compile_program(std::string vertex_source, std::string frag_source);
  */
 void render_rectangle(wf::geometry_t box, wf::color_t color, glm::mat4 matrix);
 
+/**
+ * A precomputed id for the name of a uniform or an attribute.
+ *
+ * Looking up a location by id is an array access, while looking it up by name
+ * needs to hash the name on each call, so ids should be used for uniforms and
+ * attributes which are set for every draw. Ids are global and can be used with
+ * any program, so they are typically kept in static variables.
+ *
+ * Names are kept in a global registry for the lifetime of the process, which
+ * never shrinks.
+ */
+class name_id_t
+{
+  public:
+    explicit name_id_t(const std::string& name);
+
+    /** The name this id was created from. */
+    const std::string& get_name() const;
+
+    /** A small integer, unique for each name. */
+    const uint32_t index;
+};
+
 /**
  * An OpenGL program for rendering texture_t.
  * It contains multiple programs for the different texture types.
@@ -312,6 +367,13 @@ class program_t
     /** @return The program ID for the given texture type, or 0 on failure */
     int get_program_id(wf::texture_type_t type);
 
+    /*
+     * The overloads taking a name as a string intern it with name_id_t on each
+     * call. Interned names are never freed, so the names should come from a
+     * fixed set (not be generated at runtime), and code which sets uniforms for
+     * every draw should keep name_id_t variables instead.
+     */
+
     /** Set the given uniform for the currently used program. */
     void uniform1i(const std::string& name, int value);
     /** Set the given uniform for the currently used program. */
@@ -325,6 +387,19 @@ class program_t
     /** Set the given uniform for the currently used program. */
     void uniformMatrix4f(const std::string& name, const glm::mat4& value);
 
+    /** Set the given uniform for the currently used program. */
+    void uniform1i(const name_id_t& name, int value);
+    /** Set the given uniform for the currently used program. */
+    void uniform1f(const name_id_t& name, float value);
+    /** Set the given uniform for the currently used program. */
+    void uniform2f(const name_id_t& name, float x, float y);
+    /** Set the given uniform for the currently used program. */
+    void uniform3f(const name_id_t& name, float x, float y, float z);
+    /** Set the given uniform for the currently used program. */
+    void uniform4f(const name_id_t& name, const glm::vec4& value);
+    /** Set the given uniform for the currently used program. */
+    void uniformMatrix4f(const name_id_t& name, const glm::mat4& value);
+
     /*
      * Set the attribute pointer and active the attribute.
      *
@@ -335,6 +410,10 @@ class program_t
     void attrib_pointer(const std::string& attrib,
         int size, int stride, const void *ptr, GLenum type = GL_FLOAT);
 
+    /** Same as attrib_pointer(), for a precomputed attribute name. */
+    void attrib_pointer(const name_id_t& attrib,
+        int size, int stride, const void *ptr, GLenum type = GL_FLOAT);
+
     /*
      * Set the attrib divisor. Analogous to glVertexAttribDivisor().
      *
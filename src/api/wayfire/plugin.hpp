@@ -3,6 +3,7 @@
 
 #include <functional>
 #include <string>
+#include <vector>
 #include <cstdint>
 
 class wayfire_config;
@@ -93,6 +94,24 @@ class plugin_interface_t
 
     virtual ~plugin_interface_t() = default;
 };
+
+/**
+ * Timing information about a loaded plugin, recorded by the plugin loader.
+ */
+struct plugin_load_stats_t
+{
+    // The path to the plugin's .so file, or the name of a built-in plugin.
+    std::string name;
+    // Time spent in dlopen() and newInstance(), in microseconds. Zero for built-in plugins.
+    int64_t load_us = 0;
+    // Time spent in the plugin's init(), in microseconds.
+    int64_t init_us = 0;
+};
+
+/**
+ * @return The load and init timings of all currently loaded plugins, slowest to initialize first.
+ */
+std::vector<plugin_load_stats_t> get_plugin_load_stats();
 }
 
 /**
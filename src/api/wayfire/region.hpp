@@ -12,6 +12,9 @@ struct region_t
     /* Makes a copy of the given region */
     region_t(const pixman_region32_t *damage);
     region_t(const wlr_box& box);
+    /* Makes a region which is the union of the given boxes. The boxes may
+     * overlap and empty boxes are ignored. */
+    region_t(const pixman_box32_t *boxes, int count);
     ~region_t();
 
     region_t(const region_t& other);
@@ -24,6 +27,21 @@ struct region_t
     void clear();
 
     void expand_edges(int amount);
+
+    /**
+     * Reduce the number of rectangles in the region by replacing groups of
+     * nearby rectangles with their bounding box. The result always contains
+     * the original region.
+     *
+     * @param max_overhead How much the total area may grow, as a fraction of
+     *   the area of the region.
+     * @param max_rects If positive, rectangles are merged beyond the area
+     *   overhead until at most this many remain.
+     */
+    void simplify(double max_overhead, int max_rects = 0);
+
+    /* The number of rectangles in the region */
+    int rect_count() const;
     pixman_box32_t get_extents() const;
     bool contains_point(const point_t& point) const;
     bool contains_pointf(const pointf_t& point) const;
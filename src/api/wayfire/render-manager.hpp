@@ -5,6 +5,10 @@
 #include <wayfire/region.hpp>
 #include <wayfire/render.hpp>
 
+namespace OpenGL {
+class program_t;
+}
+
 namespace wf {
 /* Effect hooks provide the plugins with a way to execute custom code
  * at certain parts of the repaint cycle */
@@ -45,17 +49,55 @@ enum output_effect_type_t {
  *        the output image up to this moment.
  *
  * @param destination Indicates where the processed image should be stored.
+ *
+ * @param damage The region of the destination which needs to be repainted.
+ *        Outside of it, the destination already contains the processed image
+ *        from the previous frames.
  */
 using post_hook_t = std::function<void(wf::auxilliary_buffer_t &source,
                                        const wf::render_buffer_t &destination,
                                        const wf::region_t &damage)>;
 
+/**
+ * A postprocessing effect which computes each pixel of the output image only
+ * from the pixel at the same position in its source, for example a color
+ * filter.
+ *
+ * Consecutive pixel hooks are fused into a single shader pass, so that the
+ * image is read and written only once for all of them. Pixel hooks require the
+ * GLES renderer, with other renderers they are skipped.
+ */
+struct post_pixel_hook_t {
+  /**
+   * GLSL ES 1.00 source defining the function
+   * `highp vec4 @name@(highp vec4 color)` and the uniforms it uses. The
+   * `@name@` placeholder is replaced with a unique name when the hooks are
+   * fused, uniform names should be prefixed with the name of the plugin.
+   */
+  std::string shader;
+
+  /**
+   * Called with the fused program in use, to upload the uniforms of the hook.
+   */
+  std::function<void(OpenGL::program_t &program)> set_uniforms;
+};
+
 /**
  * The frame-done signal is emitted on an output when the frame has been
  * completed (regardless of whether new content was painted or not).
  */
 struct frame_done_signal {};
 
+/**
+ * Counters for the damage simplification of an output, cumulative since the
+ * output was created. The rect counts are summed over all frames.
+ */
+struct damage_stats_t {
+  uint64_t frames = 0;
+  uint64_t rects_before = 0;
+  uint64_t rects_after = 0;
+};
+
 /** Render manager
  *
  * Each output has a render manager, which is responsible for all rendering
@@ -90,9 +132,18 @@ public:
   /**
    * Inhibit rendering to the output. An inhibited output will show a
    * fully black image. Used mainly for compositor fade in/out on startup.
+   *
+   * While inhibited, the scene is not rendered and no repaints are scheduled,
+   * and surfaces receive frame done events only about once per second.
    */
   void add_inhibit(bool add);
 
+  /**
+   * @return Whether the output is inhibited. Inhibited outputs do not render
+   *   frames, so effect hooks are not run either.
+   */
+  bool is_inhibited() const;
+
   /**
    * Add a new effect hook.
    * @param hook The hook callback
@@ -119,6 +170,21 @@ public:
    */
   void rem_post(post_hook_t *hook);
 
+  /**
+   * Add a new pixel hook at the end of the postprocessing chain. The shader of
+   * the hook is compiled the next time the output is repainted.
+   *
+   * @param hook The hook to be added.
+   */
+  void add_post(post_pixel_hook_t *hook);
+
+  /**
+   * Remove a pixel hook. No-op if hook isn't active.
+   *
+   * @param hook The hook to be removed.
+   */
+  void rem_post(post_pixel_hook_t *hook);
+
   /**
    * @return The damaged region on the current output for the current
    * frame that is used when swapping buffers. This function should
@@ -193,6 +259,18 @@ public:
    */
   void set_require_depth_buffer(bool require);
 
+  /**
+   * @return The scratch arena which render passes on this output use for
+   * their per-frame instruction lists. It is reset after each frame.
+   */
+  wf::frame_scratch_arena_t &get_frame_scratch();
+
+  /**
+   * @return Statistics about how fragmented the damage on this output is,
+   * before and after it is simplified (see core/damage_merge_overhead).
+   */
+  wf::damage_stats_t get_damage_stats() const;
+
 public:
   class impl;
   std::unique_ptr<impl> pimpl;
@@ -167,11 +167,74 @@ struct auxilliary_buffer_t
 
   private:
     render_buffer_t buffer;
+    // The DRM format of the buffer, used to return it to the buffer pool.
+    uint32_t format = 0;
 
     // The wlr_texture creating from this framebuffer.
     wlr_texture *texture = NULL;
 };
 
+/**
+ * A pool of buffers shared by all auxilliary buffers, so that buffers which are freed (for example when
+ * an animation ends or a transformer changes its size) can be reused by the next allocation with the same
+ * size and format instead of going through the allocator again.
+ *
+ * Free buffers are reused only for allocations with exactly the same size and format, because the size
+ * of an auxilliary buffer is also the size of its texture. When their total memory exceeds
+ * core/buffer_pool_size, the least recently released buffers are destroyed.
+ */
+class buffer_pool_t
+{
+  public:
+    struct stats_t
+    {
+        /** Allocations served from the pool. */
+        uint64_t hits = 0;
+        /** Allocations which needed a new buffer. */
+        uint64_t misses = 0;
+        /** Free buffers destroyed to stay within the memory limit. */
+        uint64_t evictions = 0;
+        /** The number of free buffers in the pool. */
+        size_t buffers = 0;
+        /** The approximate memory used by the free buffers, in bytes. */
+        size_t bytes = 0;
+    };
+
+    buffer_pool_t();
+    ~buffer_pool_t();
+    buffer_pool_t(const buffer_pool_t&) = delete;
+    buffer_pool_t& operator =(const buffer_pool_t&) = delete;
+
+    /**
+     * Take a free buffer with the given size and format from the pool, or allocate a new one if there is
+     * none. Pooled dmabuf buffers are reused only if their modifier is one of the modifiers of @format.
+     *
+     * @return The buffer, or NULL if allocation failed.
+     */
+    wlr_buffer *acquire(wf::dimensions_t size, const wlr_drm_format *format);
+
+    /**
+     * Return a buffer obtained from acquire() to the pool.
+     */
+    void release(wlr_buffer *buffer, uint32_t format);
+
+    /**
+     * Destroy all free buffers.
+     */
+    void clear();
+
+    stats_t get_stats() const;
+
+    /**
+     * The pool used by auxilliary buffers.
+     */
+    static buffer_pool_t& get();
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> priv;
+};
+
 /**
  * A render target contains a render buffer and information on how to map
  * coordinates from the logical coordinate space (output-local coordinates, etc.)
@@ -252,8 +315,12 @@ struct render_target_t : public render_buffer_t
     /**
      * Get the geometry of the given framebuffer region after projecting it back to the logical coordinate
      * space.
-     * This is the same as iterating over the rects in the region and transforming them with
-     * geometry_box_from_framebuffer_box.
+     *
+     * Each rect is rounded outwards to the smallest box of whole logical pixels which contains its exact
+     * projection, so the result always covers the projected region. Transforming the rects one by one
+     * with geometry_box_from_framebuffer_box may give a larger result: with fractional scales, it can
+     * round a rect up by one more pixel on each side, where the projected coordinate is an integer up to
+     * floating point error.
      */
     wf::region_t geometry_region_from_framebuffer_region(const wf::region_t& region) const;
 };
@@ -262,8 +329,55 @@ namespace scene
 {
 class render_instance_t;
 using render_instance_uptr = std::unique_ptr<render_instance_t>;
+struct render_instruction_t;
 }
 
+/**
+ * Scratch memory for the render instructions generated during a frame.
+ *
+ * Render passes take their instruction lists from an arena instead of allocating a new vector each time,
+ * so that after the first few frames, generating instructions no longer hits the heap. Each output has
+ * its own arena, which is reset after the frame has been swapped.
+ */
+class frame_scratch_arena_t
+{
+  public:
+    using instruction_list_t = std::vector<scene::render_instruction_t>;
+
+    frame_scratch_arena_t();
+    ~frame_scratch_arena_t();
+    frame_scratch_arena_t(const frame_scratch_arena_t&) = delete;
+    frame_scratch_arena_t& operator =(const frame_scratch_arena_t&) = delete;
+
+    /**
+     * Get an empty instruction list. The list keeps the capacity it had when it was last released.
+     */
+    instruction_list_t *acquire_instructions();
+
+    /**
+     * Return a list obtained from acquire_instructions(). The list is cleared, but not deallocated.
+     */
+    void release_instructions(instruction_list_t *list);
+
+    /**
+     * Mark the end of a frame. Lists which were not needed in the last frames are freed, so that a single
+     * unusually complex frame does not pin its memory forever.
+     */
+    void reset();
+
+    /**
+     * The arena used by render passes which are not associated with an output.
+     */
+    static frame_scratch_arena_t& get_shared();
+
+  private:
+    std::vector<std::unique_ptr<instruction_list_t>> free_lists;
+    size_t in_use = 0;
+    size_t peak_in_use    = 0;
+    size_t peak_list_size = 0;
+    int frames_since_trim = 0;
+};
+
 enum render_pass_flags
 {
     /**
@@ -317,6 +431,12 @@ struct render_pass_params_t
      * Flags for this render pass, see @render_pass_flags.
      */
     uint32_t flags = 0;
+
+    /**
+     * The arena to take the instruction list from. If not set, the arena of @reference_output is used, or
+     * a shared arena if there is no reference output.
+     */
+    frame_scratch_arena_t *scratch = nullptr;
 };
 
 /**
@@ -537,5 +537,18 @@ void set_node_enabled(wf::scene::node_ptr node, bool enabled);
  * @param flags A bit mask consisting of flags defined in the @update_flag enum.
  */
 void update(node_ptr changed_node, uint32_t flags);
+
+/**
+ * Counters for the damage caused by changing the stacking order of children
+ * nodes (raising a view, sending it to the back, etc.), since startup.
+ */
+struct restack_stats_t
+{
+    uint64_t restacks = 0;
+    /* The area of the damage caused by all restacks together */
+    uint64_t damaged_pixels = 0;
+};
+
+restack_stats_t get_restack_stats();
 }
 } // namespace wf
@@ -4,6 +4,8 @@
 #include "wayfire/view.hpp"
 #include "wayfire/output.hpp"
 
+#include <set>
+
 /**
  * Documentation of signals emitted from core components.
  * Each signal documentation follows the following scheme:
@@ -189,10 +191,29 @@ struct touch_focus_changed_signal
 
 /**
  * on: core
- * when: When the config file is reloaded
+ * when: When the config file is reloaded, or options are changed over IPC.
  */
 struct reload_config_signal
-{};
+{
+    /**
+     * Whether any option might have changed. If false, only the options in
+     * changed_options have changed.
+     */
+    bool full_reload = true;
+
+    /* The options which changed, as section/option */
+    std::vector<std::string> changed_options;
+    /* The sections of the options which changed */
+    std::set<std::string> changed_sections;
+
+    /**
+     * @return Whether options in the given section might have changed.
+     */
+    bool section_changed(const std::string& section) const
+    {
+        return full_reload || changed_sections.count(section);
+    }
+};
 
 /**
  * on: core
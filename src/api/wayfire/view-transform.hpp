@@ -6,13 +6,90 @@
 #include "wayfire/region.hpp"
 #include "wayfire/scene-render.hpp"
 #include "wayfire/scene.hpp"
+#include "wayfire/util.hpp"
+#include <cmath>
+#include <functional>
+#include <map>
 #include <memory>
+#include <optional>
 #include <wayfire/render.hpp>
 
 namespace wf
 {
 namespace scene
 {
+/**
+ * Compute the render target and damage with which the children of a
+ * transformer can render directly to @target.
+ *
+ * This is possible if @to_local (mapping @target's coordinates to the
+ * children's coordinates) is a translation combined with a uniform positive
+ * scale, and the children's damage can be chosen so that it covers exactly
+ * the framebuffer pixels of @damage. This is the case if:
+ *
+ * 1. Each logical pixel of @target maps to whole logical pixels of the
+ *    children, for example a translation by whole pixels.
+ * 2. Each framebuffer pixel covers whole logical pixels of the children, for
+ *    example a view scaled to 1/2 or 1/3 on an output with scale 1. The
+ *    children's origin is snapped to a logical pixel, which moves them by
+ *    less than half a framebuffer pixel.
+ *
+ * With any other mapping, the children's damage would have to be rounded,
+ * and they could paint framebuffer pixels outside of @damage.
+ *
+ * @return The target and damage for the children, or nothing if the mapping
+ *   is not exact.
+ */
+inline std::optional<std::pair<wf::render_target_t, wf::region_t>> direct_render_target(
+    const wf::render_target_t& target, const wf::region_t& damage,
+    const std::function<wf::pointf_t(wf::pointf_t)>& to_local)
+{
+    constexpr double EPSILON = 1e-3;
+    auto is_integer = [] (double value) { return std::abs(value - std::round(value)) < EPSILON; };
+
+    const auto& g = target.geometry;
+    auto p1 = to_local({1.0 * g.x, 1.0 * g.y});
+    auto p2 = to_local({1.0 * g.x + g.width, 1.0 * g.y + g.height});
+
+    // How many logical pixels of the children one logical pixel of the target covers
+    const double k = (p2.x - p1.x) / g.width;
+    if ((k < EPSILON) || (std::abs((p2.y - p1.y) / g.height - k) >= EPSILON))
+    {
+        return {};
+    }
+
+    wf::render_target_t child_target = target;
+    child_target.geometry = {
+        (int)std::round(p1.x), (int)std::round(p1.y),
+        (int)std::round(g.width * k), (int)std::round(g.height * k),
+    };
+    child_target.scale = target.scale / k;
+
+    auto pixels = target.framebuffer_region_from_geometry_region(damage);
+    wf::region_t child_damage;
+    if (is_integer(k) && is_integer(p1.x) && is_integer(p1.y))
+    {
+        child_damage = (damage - wf::point_t{g.x, g.y}) * (float)std::round(k);
+        child_damage += wf::origin(child_target.geometry);
+    } else if (is_integer(k / target.scale))
+    {
+        child_damage = child_target.geometry_region_from_framebuffer_region(pixels);
+    } else
+    {
+        return {};
+    }
+
+    // The scale of the children's target is a float, which may be inexact.
+    // Make sure that the children paint exactly the damaged pixels.
+    auto child_pixels = child_target.framebuffer_region_from_geometry_region(child_damage);
+    if (!(child_pixels ^ pixels).empty() || !(pixels ^ child_pixels).empty())
+    {
+        return {};
+    }
+
+    return std::make_pair(child_target, std::move(child_damage));
+}
+
 class zero_copy_texturable_node_t
 {
   public:
@@ -64,8 +141,37 @@ class transformer_base_node_t : public scene::floating_inner_node_t
     wf::texture_t get_updated_contents(const wf::geometry_t& bbox, float scale,
         std::vector<scene::render_instance_uptr>& children);
 
+    /**
+     * Choose the scale at which the children should be rendered to
+     * @inner_content, so that views which are shrunk on screen are not
+     * rendered at full resolution.
+     *
+     * The result follows the effective scale (@target_scale times
+     * @transform_scale, at most @target_scale), with hysteresis: during an
+     * animation the buffer is reallocated only when its scale is far off, and
+     * it is adjusted to the exact scale once the animation has settled. The
+     * hysteresis is tracked separately for each target scale, so that a view
+     * shown on outputs with different scales does not reset it every frame.
+     *
+     * @param target_scale The scale of the render target.
+     * @param transform_scale How much the transformer scales its children.
+     */
+    float get_content_scale(float target_scale, float transform_scale);
+
     void release_buffers();
     ~transformer_base_node_t();
+
+  private:
+    struct content_scale_state_t
+    {
+        float content_scale   = 0.0f;
+        float requested_scale = 0.0f;
+        int settled_frames    = 0;
+    };
+
+    // Keyed by the target scale
+    std::map<float, content_scale_state_t> content_scales;
+    wf::wl_idle_call settle_idle;
 };
 
 /**
@@ -118,7 +224,7 @@ class transformer_render_instance_t : public render_instance_t
      *
      * @param scale The scale to use when generating the texture. The scale
      *   indicates how much bigger the temporary buffer should be than its logical
-     *   size.
+     *   size, see transformer_base_node_t::get_content_scale().
      */
     wf::texture_t get_texture(float scale)
     {
@@ -145,6 +251,48 @@ class transformer_render_instance_t : public render_instance_t
     virtual void transform_damage_region(wf::region_t& damage)
     {}
 
+    /**
+     * Transformers which only translate and scale their children, without
+     * changing their colors or alpha, can let the children render directly to
+     * the render target, with a target geometry and scale adjusted by the
+     * transform. This skips rendering the children to @inner_content first.
+     *
+     * The direct path is used only if the transform maps the framebuffer
+     * pixels exactly, see direct_render_target().
+     *
+     * @return Whether the current transform allows rendering directly.
+     */
+    virtual bool can_render_directly()
+    {
+        return false;
+    }
+
+    /**
+     * @return Whether the children were scheduled directly. If the transform
+     *   does not map the framebuffer pixels exactly, nothing is scheduled.
+     */
+    bool schedule_direct_instructions(std::vector<render_instruction_t>& instructions,
+        const wf::render_target_t& target, const wf::region_t& damage)
+    {
+        auto direct = direct_render_target(target, damage & self->get_bounding_box(),
+            [&] (wf::pointf_t point) { return self->to_local(point); });
+        if (!direct)
+        {
+            return false;
+        }
+
+        // The buffer is not needed now. If the transform changes so that it is
+        // needed again, it is reallocated and repainted fully.
+        self->release_buffers();
+        self->cached_damage.clear();
+        for (auto& ch : children)
+        {
+            ch->schedule_instructions(instructions, direct->first, direct->second);
+        }
+
+        return true;
+    }
+
     wf::output_t *_shown_on;
     damage_callback _push_damage;
 
@@ -193,7 +341,12 @@ class transformer_render_instance_t : public render_instance_t
         std::vector<render_instruction_t>& instructions,
         const wf::render_target_t& target, wf::region_t& damage) override
     {
-        if (!damage.empty())
+        if (damage.empty())
+        {
+            return;
+        }
+
+        if (!can_render_directly() || !schedule_direct_instructions(instructions, target, damage))
         {
             auto our_damage = damage & self->get_bounding_box();
             instructions.push_back(wf::scene::render_instruction_t{
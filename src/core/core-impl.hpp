@@ -2,6 +2,7 @@
 #define WF_CORE_CORE_IMPL_HPP
 
 #include "src/core/plugin-loader.hpp"
+#include "src/core/spawn-helper.hpp"
 #include "wayfire/core.hpp"
 #include "wayfire/scene-input.hpp"
 #include "wayfire/scene.hpp"
@@ -21,6 +22,7 @@ public:
   std::unique_ptr<wf::input_manager_t> input;
   std::unique_ptr<input_method_relay> im_relay;
   std::unique_ptr<plugin_manager_t> plugin_mgr;
+  std::unique_ptr<spawn_helper_t> spawn_helper;
 
   virtual void init();
   virtual void post_init();
@@ -48,6 +50,8 @@ public:
 
   std::string get_xwayland_display() override;
   pid_t run(std::string command) override;
+  void run_async(std::string command,
+                 std::function<void(pid_t)> callback) override;
   void shutdown() override;
   compositor_state_t get_current_state() override;
   const std::shared_ptr<scene::root_node_t> &scene() final;
@@ -77,6 +81,11 @@ protected:
   void increase_nofile_limit();
   void restore_nofile_limit();
 
+  /** The environment of processes started with run(). */
+  std::vector<std::string> get_run_environment();
+  /** Start a process without the spawn helper, by forking the compositor. */
+  pid_t run_forked(std::string command);
+
 private:
   wf::option_wrapper_t<bool> discard_command_output;
   static std::unique_ptr<compositor_core_impl_t> static_core;
@@ -10,7 +10,9 @@
 #include "wayfire/scene.hpp"
 #include "wayfire/txn/transaction-manager.hpp"
 #include "wayfire/util.hpp"
+#include <map>
 #include <memory>
+#include <string_view>
 #include <wayfire/nonstd/tracking-allocator.hpp>
 #include <wayfire/workarea.hpp>
 
@@ -26,6 +28,7 @@
 #include <wayfire/nonstd/wlroots-full.hpp>
 #include <wayfire/output-layout.hpp>
 #include <wayfire/output.hpp>
+#include <wayfire/render.hpp>
 #include <wayfire/signal-definitions.hpp>
 #include <wayfire/util/log.hpp>
 #include <wayfire/workspace-set.hpp>
@@ -227,6 +230,9 @@ void wf::compositor_core_impl_t::init() {
   }
 
   increase_nofile_limit();
+  if (spawn_helper) {
+    spawn_helper->attach(ev_loop);
+  }
 
   this->state = compositor_state_t::START_BACKEND;
 }
@@ -317,6 +323,7 @@ void wf::compositor_core_impl_t::fini() {
   LOGI("Unloading plugins...");
   plugin_mgr.reset();
   _clear_data();
+  spawn_helper.reset();
 
   // Shut down xwayland first, otherwise, wlroots will attempt to restart it
   // when we kill it via wl_display_destroy_clients().
@@ -335,6 +342,8 @@ void wf::compositor_core_impl_t::fini() {
   input.reset();
   output_layout.reset();
   tx_manager.reset();
+  image_io::fini();
+  wf::buffer_pool_t::get().clear();
   OpenGL::fini();
   disconnect_signals();
   wl_display_destroy(static_core->display);
@@ -404,7 +413,41 @@ wlr_cursor *wf::compositor_core_impl_t::get_wlr_cursor() {
 }
 
 std::vector<wayfire_view> wf::compositor_core_t::get_all_views() {
-  return wf::tracking_allocator_t<view_interface_t>::get().get_all();
+  // The list may contain freed views if this is called from a for_each().
+  std::vector<wayfire_view> views;
+  for (auto &view : wf::tracking_allocator_t<view_interface_t>::get().get_all()) {
+    if (view) {
+      views.push_back(view);
+    }
+  }
+
+  return views;
+}
+
+std::vector<std::string> wf::compositor_core_impl_t::get_run_environment() {
+  std::map<std::string, std::string> overrides = {
+      {"_JAVA_AWT_WM_NONREPARENTING", "1"},
+      {"WAYLAND_DISPLAY", wayland_display},
+  };
+#if WF_HAS_XWAYLAND
+  if (!xwayland_get_display().empty()) {
+    overrides["DISPLAY"] = xwayland_get_display();
+  }
+
+#endif
+  std::vector<std::string> env;
+  for (char **it = environ; *it; ++it) {
+    std::string_view entry = *it;
+    if (!overrides.count(std::string(entry.substr(0, entry.find('='))))) {
+      env.emplace_back(entry);
+    }
+  }
+
+  for (auto &[key, value] : overrides) {
+    env.push_back(key + "=" + value);
+  }
+
+  return env;
 }
 
 /**
@@ -412,6 +455,31 @@ std::vector<wayfire_view> wf::compositor_core_t::get_all_views() {
  * Returns 0 in case of failure.
  */
 pid_t wf::compositor_core_impl_t::run(std::string command) {
+  if (spawn_helper) {
+    pid_t pid = spawn_helper->spawn_sync(command, get_run_environment(),
+                                         discard_command_output);
+    if (pid >= 0) {
+      return pid;
+    }
+  }
+
+  return run_forked(command);
+}
+
+void wf::compositor_core_impl_t::run_async(
+    std::string command, std::function<void(pid_t)> callback) {
+  if (spawn_helper && spawn_helper->spawn(command, get_run_environment(),
+                                          discard_command_output, callback)) {
+    return;
+  }
+
+  pid_t pid = run_forked(command);
+  if (callback) {
+    callback(pid);
+  }
+}
+
+pid_t wf::compositor_core_impl_t::run_forked(std::string command) {
   static constexpr size_t READ_END = 0;
   static constexpr size_t WRITE_END = 1;
 
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "wayfire/img.hpp"
+#include <sys/stat.h>
+
+/* Internal parts of image_io, used by the tests */
+namespace image_io
+{
+/**
+ * Encode RGBA pixels as a QOI image.
+ *
+ * @param invert Whether the rows are stored bottom to top.
+ */
+std::vector<uint8_t> encode_qoi(const uint8_t *pixels, int w, int h, bool invert);
+
+/* The on-disk cache of decoded images, see core/image_cache_dir */
+/**
+ * The key identifies the source file and the scaling applied to it, so that
+ * modifying the file invalidates its entries. It is stored in the cache entry
+ * as well, so that hash collisions are detected.
+ */
+std::string cache_key(const std::string& name, const struct stat& st,
+    wf::dimensions_t size);
+
+/** The file in @dir where the entry with the given key is stored. */
+std::string cache_entry_path(const std::string& dir, const std::string& key);
+
+/** @return false if there is no valid entry with the given key at @path. */
+bool read_cache_entry(const std::string& path, const std::string& key,
+    decoded_image_t& image);
+
+/** Atomically replace the entry at @path, creating @dir if needed. */
+void write_cache_entry(const std::string& dir, const std::string& path,
+    const std::string& key, const decoded_image_t& image);
+}
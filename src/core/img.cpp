@@ -4,6 +4,9 @@
 #include "wayfire/img.hpp"
 #include "wayfire/opengl.hpp"
 #include "wayfire/core.hpp"
+#include "wayfire/option-wrapper.hpp"
+#include "wayfire/util.hpp"
+#include "img-impl.hpp"
 
 #include <config.h>
 
@@ -16,7 +19,18 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csetjmp>
 #include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <functional>
 
@@ -24,8 +38,8 @@
 
 namespace image_io
 {
-using Loader = std::function<bool (const char*, GLuint)>;
-using Writer = std::function<void (const char*name, uint8_t*pixels, unsigned long,
+using Loader = std::function<bool (const char*, decoded_image_t&)>;
+using Writer = std::function<bool (const char*name, uint8_t*pixels, unsigned long,
     unsigned long, bool)>;
 namespace
 {
@@ -33,7 +47,7 @@ std::unordered_map<std::string, Loader> loaders;
 std::unordered_map<std::string, Writer> writers;
 }
 
-bool load_data_as_cubemap(unsigned char *data, int width, int height, int channels)
+bool load_data_as_cubemap(const unsigned char *data, int width, int height, int channels)
 {
     width  /= 4;
     height /= 3;
@@ -105,6 +119,7 @@ bool load_data_as_cubemap(unsigned char *data, int width, int height, int channe
         }
 
         auto format = (channels == 4 ? GL_RGBA : GL_RGB);
+        GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
         GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, width * 4));
         GL_CALL(glPixelStorei(GL_UNPACK_SKIP_ROWS, y * height));
         GL_CALL(glPixelStorei(GL_UNPACK_SKIP_PIXELS, x * width));
@@ -116,6 +131,7 @@ bool load_data_as_cubemap(unsigned char *data, int width, int height, int channe
     GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
     GL_CALL(glPixelStorei(GL_UNPACK_SKIP_ROWS, 0));
     GL_CALL(glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0));
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
 
     return true;
 }
@@ -123,13 +139,14 @@ bool load_data_as_cubemap(unsigned char *data, int width, int height, int channe
 #ifdef BUILD_WITH_IMAGEIO
 /* All backend functions are taken from the internet.
  * If you want to be credited, contact me */
-bool texture_from_png(const char *filename, GLuint target)
+bool decode_png(const char *filename, decoded_image_t& image)
 {
     FILE *fp = fopen(filename, "rb");
-    int width, height;
-    png_byte color_type;
-    png_byte bit_depth;
-    png_bytep *row_pointers;
+    if (!fp)
+    {
+        LOGE("failed to read PNG file ", filename);
+        return false;
+    }
 
     png_structp png =
         png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
@@ -142,12 +159,16 @@ bool texture_from_png(const char *filename, GLuint target)
     png_infop infos = png_create_info_struct(png);
     if (!infos)
     {
+        png_destroy_read_struct(&png, NULL, NULL);
         fclose(fp);
         return false;
     }
 
+    // Locals changed after setjmp() have unspecified values after an error, so
+    // nothing below this point may own memory which has to be freed on error.
     if (setjmp(png_jmpbuf(png)))
     {
+        png_destroy_read_struct(&png, &infos, NULL);
         fclose(fp);
         return false;
     }
@@ -155,10 +176,10 @@ bool texture_from_png(const char *filename, GLuint target)
     png_init_io(png, fp);
     png_read_info(png, infos);
 
-    width  = png_get_image_width(png, infos);
-    height = png_get_image_height(png, infos);
-    color_type = png_get_color_type(png, infos);
-    bit_depth  = png_get_bit_depth(png, infos);
+    int width  = png_get_image_width(png, infos);
+    int height = png_get_image_height(png, infos);
+    png_byte color_type = png_get_color_type(png, infos);
+    png_byte bit_depth  = png_get_bit_depth(png, infos);
 
     if (bit_depth == 16)
     {
@@ -195,51 +216,36 @@ bool texture_from_png(const char *filename, GLuint target)
         png_set_gray_to_rgb(png);
     }
 
+    int passes = png_set_interlace_handling(png);
     png_read_update_info(png, infos);
 
-    row_pointers = new png_bytep[height];
-    png_byte *data = new png_byte[height * png_get_rowbytes(png, infos)];
-
-    for (int i = 0; i < height; i++)
+    // Rows are read directly into the image, so that no further copies are needed.
+    size_t stride = png_get_rowbytes(png, infos);
+    image.width    = width;
+    image.height   = height;
+    image.channels = png_get_channels(png, infos);
+    image.data.resize(height * stride);
+    for (int pass = 0; pass < passes; pass++)
     {
-        row_pointers[i] = data + i * png_get_rowbytes(png, infos);
-    }
-
-    png_read_image(png, row_pointers);
-
-    if (target == GL_TEXTURE_CUBE_MAP)
-    {
-        if (!load_data_as_cubemap(data, width, height,
-            png_get_channels(png, infos)))
+        for (int i = 0; i < height; i++)
         {
-            png_destroy_read_struct(&png, &infos, NULL);
-            delete[] row_pointers;
-            delete[] data;
-            fclose(fp);
-            return false;
+            png_read_row(png, image.data.data() + i * stride, NULL);
         }
-    } else if (target == GL_TEXTURE_2D)
-    {
-        GL_CALL(glTexImage2D(target, 0, GL_RGBA, width, height, 0,
-            GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)data));
     }
 
     png_destroy_read_struct(&png, &infos, NULL);
-    delete[] row_pointers;
-    delete[] data;
-
     fclose(fp);
 
     return true;
 }
 
-void texture_to_png(const char *name, uint8_t *pixels, int w, int h, bool invert)
+bool texture_to_png(const char *name, uint8_t *pixels, int w, int h, bool invert)
 {
     png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr,
         nullptr, nullptr);
     if (!png)
     {
-        return;
+        return false;
     }
 
     png_infop infot = png_create_info_struct(png);
@@ -247,7 +253,7 @@ void texture_to_png(const char *name, uint8_t *pixels, int w, int h, bool invert
     {
         png_destroy_write_struct(&png, &infot);
 
-        return;
+        return false;
     }
 
     FILE *fp = fopen(name, "wb");
@@ -255,7 +261,7 @@ void texture_to_png(const char *name, uint8_t *pixels, int w, int h, bool invert
     {
         png_destroy_write_struct(&png, &infot);
 
-        return;
+        return false;
     }
 
     png_init_io(png, fp);
@@ -269,7 +275,7 @@ void texture_to_png(const char *name, uint8_t *pixels, int w, int h, bool invert
         fclose(fp);
         png_destroy_write_struct(&png, &infot);
 
-        return;
+        return false;
     }
 
     png_set_PLTE(png, infot, palette, PNG_MAX_PALETTE_LENGTH);
@@ -291,24 +297,37 @@ void texture_to_png(const char *name, uint8_t *pixels, int w, int h, bool invert
     png_write_image(png, rows);
     png_write_end(png, infot);
     png_free(png, palette);
+    png_free(png, rows);
     png_destroy_write_struct(&png, &infot);
 
-    fclose(fp);
-    png_free(png, rows);
+    return fclose(fp) == 0;
+}
+
+namespace
+{
+/* The default error handler of libjpeg calls exit(), jump back instead. */
+struct jpeg_error_handler_t
+{
+    jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
+}
+
+static void jpeg_error_exit(j_common_ptr info)
+{
+    char message[JMSG_LENGTH_MAX];
+    info->err->format_message(info, message);
+    LOGE("failed to decode JPEG: ", message);
+    longjmp(((jpeg_error_handler_t*)info->err)->jump, 1);
 }
 
-bool texture_from_jpeg(const char *FileName, GLuint target)
+bool decode_jpeg(const char *FileName, decoded_image_t& image)
 {
-    unsigned long data_size;
     unsigned char *rowptr[1];
-    unsigned char *jdata;
     struct jpeg_decompress_struct infot;
-    struct jpeg_error_mgr err;
+    jpeg_error_handler_t err;
 
     std::FILE *file = fopen(FileName, "rb");
-    infot.err = jpeg_std_error(&err);
-    jpeg_create_decompress(&infot);
-
     if (!file)
     {
         LOGE("failed to read JPEG file ", FileName);
@@ -316,48 +335,255 @@ bool texture_from_jpeg(const char *FileName, GLuint target)
         return false;
     }
 
+    infot.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = jpeg_error_exit;
+
+    // As with PNG, nothing below this point may own memory which has to be
+    // freed on error, except for the decompressor and the file.
+    if (setjmp(err.jump))
+    {
+        jpeg_destroy_decompress(&infot);
+        fclose(file);
+        return false;
+    }
+
+    jpeg_create_decompress(&infot);
+
     jpeg_stdio_src(&infot, file);
     jpeg_read_header(&infot, TRUE);
+    // The rows below have 3 channels, grayscale images are converted too.
+    infot.out_color_space = JCS_RGB;
     jpeg_start_decompress(&infot);
 
-    data_size = infot.output_width * infot.output_height * 3;
-
-    jdata = new unsigned char [data_size];
+    image.width    = infot.output_width;
+    image.height   = infot.output_height;
+    image.channels = 3;
+    image.data.resize((size_t)image.width * image.height * 3);
     while (infot.output_scanline < infot.output_height)
     {
-        rowptr[0] = (unsigned char*)jdata + 3 * infot.output_width *
+        rowptr[0] = image.data.data() + 3 * infot.output_width *
             infot.output_scanline;
         jpeg_read_scanlines(&infot, rowptr, 1);
     }
 
     jpeg_finish_decompress(&infot);
+    jpeg_destroy_decompress(&infot);
+    fclose(file);
+
+    return true;
+}
 
-    GLint width  = infot.output_width;
-    GLint height = infot.output_height;
+#endif
 
-    if (target == GL_TEXTURE_CUBE_MAP)
+/* Pixels in RGBA order, without any header */
+bool texture_to_raw(const char *name, uint8_t *pixels, int w, int h, bool invert)
+{
+    FILE *fp = fopen(name, "wb");
+    if (!fp)
+    {
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < h; ++i)
+    {
+        int row = invert ? (h - i - 1) : i;
+        ok &= fwrite(pixels + (size_t)row * w * 4, 4, w, fp) == (size_t)w;
+    }
+
+    return (fclose(fp) == 0) && ok;
+}
+
+/**
+ * The "Quite OK Image" format, which compresses worse than PNG, but encodes
+ * many times faster. See https://qoiformat.org/qoi-specification.pdf
+ */
+std::vector<uint8_t> encode_qoi(const uint8_t *pixels, int w, int h, bool invert)
+{
+    enum : uint8_t
+    {
+        QOI_OP_INDEX = 0x00,
+        QOI_OP_DIFF  = 0x40,
+        QOI_OP_LUMA  = 0x80,
+        QOI_OP_RUN   = 0xc0,
+        QOI_OP_RGB   = 0xfe,
+        QOI_OP_RGBA  = 0xff,
+    };
+
+    std::vector<uint8_t> out;
+    out.reserve(14 + (size_t)w * h + 8);
+    auto put_u32 = [&] (uint32_t value)
     {
-        if (!load_data_as_cubemap(jdata, width, height, 3))
+        for (int shift = 24; shift >= 0; shift -= 8)
         {
-            fclose(file);
-            delete[] jdata;
-            return false;
+            out.push_back(value >> shift);
         }
-    } else if (target == GL_TEXTURE_2D)
+    };
+
+    out.insert(out.end(), {'q', 'o', 'i', 'f'});
+    put_u32(w);
+    put_u32(h);
+    out.push_back(4); // RGBA
+    out.push_back(0); // sRGB with linear alpha
+
+    uint8_t index[64][4] = {};
+    uint8_t prev[4] = {0, 0, 0, 255};
+    int run = 0;
+    for (int i = 0; i < h; ++i)
     {
-        GL_CALL(glTexImage2D(target, 0, GL_RGB, width, height, 0,
-            GL_RGB, GL_UNSIGNED_BYTE, jdata));
+        const uint8_t *row = pixels + (size_t)(invert ? (h - i - 1) : i) * w * 4;
+        for (int j = 0; j < w; ++j)
+        {
+            const uint8_t *px = row + j * 4;
+            if (!memcmp(px, prev, 4))
+            {
+                if (++run == 62)
+                {
+                    out.push_back(QOI_OP_RUN | (run - 1));
+                    run = 0;
+                }
+
+                continue;
+            }
+
+            if (run > 0)
+            {
+                out.push_back(QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+
+            int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+            if (!memcmp(index[hash], px, 4))
+            {
+                out.push_back(QOI_OP_INDEX | hash);
+            } else if (px[3] != prev[3])
+            {
+                memcpy(index[hash], px, 4);
+                out.insert(out.end(), {QOI_OP_RGBA, px[0], px[1], px[2], px[3]});
+            } else
+            {
+                memcpy(index[hash], px, 4);
+                int8_t dr = px[0] - prev[0];
+                int8_t dg = px[1] - prev[1];
+                int8_t db = px[2] - prev[2];
+                int8_t dr_dg = dr - dg;
+                int8_t db_dg = db - dg;
+                if ((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) && (db <= 1))
+                {
+                    out.push_back(QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                } else if ((dg >= -32) && (dg <= 31) && (dr_dg >= -8) && (dr_dg <= 7) &&
+                           (db_dg >= -8) && (db_dg <= 7))
+                {
+                    out.push_back(QOI_OP_LUMA | (dg + 32));
+                    out.push_back(((dr_dg + 8) << 4) | (db_dg + 8));
+                } else
+                {
+                    out.insert(out.end(), {QOI_OP_RGB, px[0], px[1], px[2]});
+                }
+            }
+
+            memcpy(prev, px, 4);
+        }
     }
 
-    fclose(file);
-    delete[] jdata;
+    if (run > 0)
+    {
+        out.push_back(QOI_OP_RUN | (run - 1));
+    }
 
-    return true;
+    out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    return out;
 }
 
-#endif
+bool texture_to_qoi(const char *name, uint8_t *pixels, int w, int h, bool invert)
+{
+    auto out = encode_qoi(pixels, w, h, invert);
+    FILE *fp = fopen(name, "wb");
+    if (!fp)
+    {
+        return false;
+    }
 
-bool load_from_file(std::string name, GLuint target)
+    bool ok = fwrite(out.data(), 1, out.size(), fp) == out.size();
+    return (fclose(fp) == 0) && ok;
+}
+
+void scale_image(decoded_image_t& image, wf::dimensions_t size)
+{
+    if ((size.width <= 0) || (size.height <= 0) ||
+        ((size.width == image.width) && (size.height == image.height)) ||
+        (image.width <= 0) || (image.height <= 0))
+    {
+        return;
+    }
+
+    const int channels = image.channels;
+    const bool shrink  = (size.width <= image.width) && (size.height <= image.height);
+    std::vector<uint8_t> scaled((size_t)size.width * size.height * channels);
+
+    auto source = [&] (int x, int y)
+    {
+        return &image.data[((size_t)y * image.width + x) * channels];
+    };
+
+    for (int y = 0; y < size.height; y++)
+    {
+        for (int x = 0; x < size.width; x++)
+        {
+            uint8_t *out = &scaled[((size_t)y * size.width + x) * channels];
+            if (shrink)
+            {
+                int x0 = (int64_t)x * image.width / size.width;
+                int x1 = std::max<int>(x0 + 1, (int64_t)(x + 1) * image.width / size.width);
+                int y0 = (int64_t)y * image.height / size.height;
+                int y1 = std::max<int>(y0 + 1, (int64_t)(y + 1) * image.height / size.height);
+
+                uint64_t sum[4] = {0, 0, 0, 0};
+                for (int sy = y0; sy < y1; sy++)
+                {
+                    for (int sx = x0; sx < x1; sx++)
+                    {
+                        const uint8_t *in = source(sx, sy);
+                        for (int c = 0; c < channels; c++)
+                        {
+                            sum[c] += in[c];
+                        }
+                    }
+                }
+
+                const uint64_t count = (uint64_t)(x1 - x0) * (y1 - y0);
+                for (int c = 0; c < channels; c++)
+                {
+                    out[c] = (sum[c] + count / 2) / count;
+                }
+            } else
+            {
+                float sx = std::clamp((x + 0.5f) * image.width / size.width - 0.5f,
+                    0.0f, image.width - 1.0f);
+                float sy = std::clamp((y + 0.5f) * image.height / size.height - 0.5f,
+                    0.0f, image.height - 1.0f);
+                int x0 = sx, y0 = sy;
+                int x1 = std::min(x0 + 1, image.width - 1);
+                int y1 = std::min(y0 + 1, image.height - 1);
+                float fx = sx - x0, fy = sy - y0;
+
+                for (int c = 0; c < channels; c++)
+                {
+                    float top = source(x0, y0)[c] * (1 - fx) + source(x1, y0)[c] * fx;
+                    float bottom = source(x0, y1)[c] * (1 - fx) + source(x1, y1)[c] * fx;
+                    out[c] = top * (1 - fy) + bottom * fy + 0.5f;
+                }
+            }
+        }
+    }
+
+    image.width  = size.width;
+    image.height = size.height;
+    image.data   = std::move(scaled);
+}
+
+bool decode_file(const std::string& name, decoded_image_t& image,
+    wf::dimensions_t target_size)
 {
     if (access(name.c_str(), F_OK) == -1)
     {
@@ -372,8 +598,8 @@ bool load_from_file(std::string name, GLuint target)
     int len = name.length();
     if ((len < 4) || (name[len - 4] != '.'))
     {
-        LOGE(
-            "load_from_file() called with file without extension or with invalid extension!");
+        LOGE(__func__,
+            "() called with file without extension or with invalid extension!");
 
         return false;
     }
@@ -387,13 +613,382 @@ bool load_from_file(std::string name, GLuint target)
     auto it = loaders.find(ext);
     if (it == loaders.end())
     {
-        LOGE("load_from_file() called with unsupported extension ", ext);
+        LOGE(__func__, "() called with unsupported extension ", ext);
 
         return false;
-    } else
+    }
+
+    if (!it->second(name.c_str(), image))
+    {
+        return false;
+    }
+
+    scale_image(image, target_size);
+    return true;
+}
+
+bool upload_to_texture(const decoded_image_t& image, GLuint target)
+{
+    if (target == GL_TEXTURE_CUBE_MAP)
     {
-        return it->second(name.c_str(), target);
+        return load_data_as_cubemap(image.data.data(), image.width, image.height,
+            image.channels);
     }
+
+    if (target != GL_TEXTURE_2D)
+    {
+        LOGE("unsupported texture target for image upload ", target);
+        return false;
+    }
+
+    auto format = (image.channels == 4 ? GL_RGBA : GL_RGB);
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_CALL(glTexImage2D(target, 0, format, image.width, image.height, 0,
+        format, GL_UNSIGNED_BYTE, image.data.data()));
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+
+    return true;
+}
+
+bool load_from_file(std::string name, GLuint target)
+{
+    decoded_image_t image;
+    return decode_file(name, image) && upload_to_texture(image, target);
+}
+
+/* On-disk cache of decoded images */
+namespace
+{
+struct cache_header_t
+{
+    char magic[8];
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t key_length;
+};
+
+const char cache_magic[8] = {'W', 'F', 'I', 'M', 'G', '0', '0', '1'};
+}
+
+std::string cache_key(const std::string& name, const struct stat& st,
+    wf::dimensions_t size)
+{
+    return name + '\n' + std::to_string(st.st_mtim.tv_sec) + '.' +
+           std::to_string(st.st_mtim.tv_nsec) + '\n' + std::to_string(size.width) +
+           'x' + std::to_string(size.height);
+}
+
+std::string cache_entry_path(const std::string& dir, const std::string& key)
+{
+    char hash[32];
+    snprintf(hash, sizeof(hash), "%016zx", std::hash<std::string>{}(key));
+    return dir + "/" + hash + ".img";
+}
+
+bool read_cache_entry(const std::string& path, const std::string& key,
+    decoded_image_t& image)
+{
+    std::ifstream in(path, std::ios::binary);
+    cache_header_t header;
+    if (!in.read((char*)&header, sizeof(header)) ||
+        memcmp(header.magic, cache_magic, sizeof(cache_magic)) ||
+        (header.key_length != key.size()) ||
+        ((header.channels != 3) && (header.channels != 4)))
+    {
+        return false;
+    }
+
+    std::string stored_key(header.key_length, '\0');
+    if (!in.read(stored_key.data(), stored_key.size()) || (stored_key != key))
+    {
+        return false;
+    }
+
+    image.width    = header.width;
+    image.height   = header.height;
+    image.channels = header.channels;
+    image.data.resize((size_t)header.width * header.height * header.channels);
+    return (bool)in.read((char*)image.data.data(), image.data.size());
+}
+
+void write_cache_entry(const std::string& dir, const std::string& path,
+    const std::string& key, const decoded_image_t& image)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    // Write to a temporary file first, so that concurrent readers never see a
+    // partially written entry.
+    std::string tmp_path = path + ".XXXXXX";
+    int fd = mkstemp(tmp_path.data());
+    if (fd < 0)
+    {
+        return;
+    }
+
+    cache_header_t header;
+    memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.width      = image.width;
+    header.height     = image.height;
+    header.channels   = image.channels;
+    header.key_length = key.size();
+
+    FILE *file = fdopen(fd, "wb");
+    bool ok    = file &&
+        (fwrite(&header, sizeof(header), 1, file) == 1) &&
+        (fwrite(key.data(), 1, key.size(), file) == key.size()) &&
+        (fwrite(image.data.data(), 1, image.data.size(), file) == image.data.size());
+    ok &= file && (fclose(file) == 0);
+    if (!file)
+    {
+        close(fd);
+    }
+
+    if (!ok || (rename(tmp_path.c_str(), path.c_str()) != 0))
+    {
+        unlink(tmp_path.c_str());
+    }
+}
+
+namespace
+{
+std::shared_ptr<decoded_image_t> decode_with_cache(const std::string& name,
+    wf::dimensions_t size, const std::string& cache_dir)
+{
+    auto image = std::make_shared<decoded_image_t>();
+
+    struct stat st;
+    std::string key, path;
+    if (!cache_dir.empty() && (stat(name.c_str(), &st) == 0))
+    {
+        key  = cache_key(name, st, size);
+        path = cache_entry_path(cache_dir, key);
+        if (read_cache_entry(path, key, *image))
+        {
+            return image;
+        }
+    }
+
+    if (!decode_file(name, *image, size))
+    {
+        return nullptr;
+    }
+
+    if (!path.empty())
+    {
+        write_cache_entry(cache_dir, path, key, *image);
+    }
+
+    return image;
+}
+}
+
+struct async_load_t::request_t
+{
+    std::string name;
+    wf::dimensions_t target_size;
+    std::string cache_dir;
+    load_callback_t callback;
+
+    /* Set when the handle is destroyed, checked by the workers and the main loop */
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> done{false};
+    std::shared_ptr<decoded_image_t> result;
+};
+
+namespace
+{
+/**
+ * A pool of threads running jobs in the background. Each job has a completion
+ * callback, which is called on the main loop through an eventfd once the job
+ * is finished.
+ */
+class worker_pool_t
+{
+  public:
+    using job_t = std::function<void ()>;
+
+    void submit(job_t job, job_t done)
+    {
+        if (workers.empty())
+        {
+            start();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queued.push_back({std::move(job), std::move(done)});
+        }
+
+        queue_changed.notify_one();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            queued.clear();
+        }
+
+        queue_changed.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+
+        workers.clear();
+        finished.clear();
+        if (event_source)
+        {
+            wl_event_source_remove(event_source);
+            event_source = nullptr;
+        }
+
+        if (event_fd >= 0)
+        {
+            close(event_fd);
+            event_fd = -1;
+        }
+    }
+
+  private:
+    struct task_t
+    {
+        job_t job;
+        job_t done;
+    };
+
+    std::mutex mutex;
+    std::condition_variable queue_changed;
+    std::deque<task_t> queued;
+    std::vector<job_t> finished;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+    int event_fd = -1;
+    wl_event_source *event_source = nullptr;
+
+    void start()
+    {
+        event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        event_source = wl_event_loop_add_fd(wf::get_core().ev_loop, event_fd,
+            WL_EVENT_READABLE, handle_finished, this);
+
+        // Decoding and encoding are mostly CPU-bound, but leave some cores to
+        // the compositor and the clients.
+        size_t nr_workers = std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 1, 4);
+        stopping = false;
+        for (size_t i = 0; i < nr_workers; i++)
+        {
+            workers.emplace_back([this] { worker_main(); });
+        }
+    }
+
+    void worker_main()
+    {
+        while (true)
+        {
+            task_t task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queue_changed.wait(lock, [&] { return stopping || !queued.empty(); });
+                if (stopping)
+                {
+                    return;
+                }
+
+                task = std::move(queued.front());
+                queued.pop_front();
+            }
+
+            task.job();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.push_back(std::move(task.done));
+            }
+
+            uint64_t one = 1;
+            if (write(event_fd, &one, sizeof(one)) < 0)
+            {
+                LOGE("failed to notify the main loop of a finished image job");
+            }
+        }
+    }
+
+    static int handle_finished(int fd, uint32_t mask, void *data)
+    {
+        auto self = (worker_pool_t*)data;
+
+        uint64_t count;
+        if (read(fd, &count, sizeof(count)) < 0)
+        {
+            return 0;
+        }
+
+        std::vector<job_t> ready;
+        {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            std::swap(ready, self->finished);
+        }
+
+        for (auto& done : ready)
+        {
+            done();
+        }
+
+        return 0;
+    }
+};
+
+worker_pool_t worker_pool;
+}
+
+async_load_t::async_load_t(std::shared_ptr<request_t> request) :
+    request(std::move(request))
+{}
+
+async_load_t::~async_load_t()
+{
+    request->cancelled = true;
+}
+
+bool async_load_t::pending() const
+{
+    return !request->done;
+}
+
+std::unique_ptr<async_load_t> load_from_file_async(std::string name,
+    wf::dimensions_t target_size, load_callback_t callback)
+{
+    static wf::option_wrapper_t<std::string> cache_dir{"core/image_cache_dir"};
+
+    auto request = std::make_shared<async_load_t::request_t>();
+    request->name        = std::move(name);
+    request->target_size = target_size;
+    request->cache_dir   = cache_dir;
+    request->callback    = std::move(callback);
+
+    worker_pool.submit([request]
+    {
+        if (!request->cancelled)
+        {
+            request->result = decode_with_cache(request->name,
+                request->target_size, request->cache_dir);
+        }
+    }, [request]
+    {
+        request->done = true;
+        if (!request->cancelled)
+        {
+            // The callback may destroy the handle, so move it out of the request first.
+            auto callback = std::move(request->callback);
+            callback(std::move(request->result));
+        }
+    });
+
+    return std::make_unique<async_load_t>(std::move(request));
 }
 
 void write_to_file(std::string name, uint8_t *pixels, int w, int h, std::string type,
@@ -410,33 +1005,254 @@ void write_to_file(std::string name, uint8_t *pixels, int w, int h, std::string
     }
 }
 
-void write_to_file(std::string name, const wf::render_buffer_t& fb)
+/* Read the buffer's pixels in RGBA order, blocking until rendering is done */
+static bool read_buffer_pixels(const wf::render_buffer_t& fb, std::vector<uint8_t>& pixels)
 {
     auto tex = wlr_texture_from_buffer(wf::get_core().renderer, fb.get_buffer());
+    if (!tex)
+    {
+        LOGE("failed to create a texture to read pixels from");
+        return false;
+    }
 
-    std::vector<char> buffer(tex->width * tex->height * 4);
+    pixels.resize((size_t)tex->width * tex->height * 4);
     wlr_texture_read_pixels_options opts{};
-    opts.data   = buffer.data();
+    opts.data   = pixels.data();
     opts.format = DRM_FORMAT_ABGR8888;
     opts.stride = tex->width * 4;
-    if (!wlr_texture_read_pixels(tex, &opts))
+    bool ok = wlr_texture_read_pixels(tex, &opts);
+    if (!ok)
     {
         LOGE("failed to read pixels from texture");
-        wlr_texture_destroy(tex);
-        return;
     }
 
-    write_to_file(name, (uint8_t*)buffer.data(), tex->width, tex->height, "png", false);
     wlr_texture_destroy(tex);
+    return ok;
+}
+
+void write_to_file(std::string name, const wf::render_buffer_t& fb)
+{
+    std::vector<uint8_t> buffer;
+    if (read_buffer_pixels(fb, buffer))
+    {
+        write_to_file(name, buffer.data(), fb.get_size().width, fb.get_size().height, "png", false);
+    }
+}
+
+/* Asynchronous captures */
+namespace
+{
+struct capture_t
+{
+    std::string name;
+    std::string type;
+    capture_callback_t callback;
+    int width  = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+    bool ok = false;
+
+    /* The pixel buffer and the fence of a pending GL readback */
+    GLuint pbo    = 0;
+    GLsync fence  = nullptr;
+};
+
+class capture_queue_t
+{
+  public:
+    capture_stats_t stats;
+
+    bool capture(const wf::render_buffer_t& buffer, std::string name, std::string type,
+        capture_callback_t callback)
+    {
+        static wf::option_wrapper_t<int> queue_size{"core/capture_queue_size"};
+        if (!writers.count(type))
+        {
+            LOGE("unsupported capture format ", type);
+            return false;
+        }
+
+        // Drop new captures instead of old ones: the old ones are already being
+        // read back or encoded, and dropping them would not free anything.
+        if (stats.pending >= (size_t)std::max(1, (int)queue_size))
+        {
+            ++stats.dropped;
+            return false;
+        }
+
+        auto cap = std::make_shared<capture_t>();
+        cap->name     = std::move(name);
+        cap->type     = std::move(type);
+        cap->callback = std::move(callback);
+        cap->width    = buffer.get_size().width;
+        cap->height   = buffer.get_size().height;
+        ++stats.pending;
+
+        if (wf::gles::ensure_context(false))
+        {
+            start_gl_readback(cap, buffer);
+        } else
+        {
+            // Other renderers have no asynchronous readback, but at least the
+            // encoding happens in the background.
+            if (!read_buffer_pixels(buffer, cap->pixels))
+            {
+                finish(cap);
+                return true;
+            }
+
+            encode(cap);
+        }
+
+        return true;
+    }
+
+    void stop()
+    {
+        poll_timer.disconnect();
+        if (!reading.empty() && wf::gles::ensure_context(false))
+        {
+            for (auto& cap : reading)
+            {
+                GL_CALL(glDeleteSync(cap->fence));
+                GL_CALL(glDeleteBuffers(1, &cap->pbo));
+            }
+        }
+
+        reading.clear();
+    }
+
+  private:
+    /* Captures waiting for the GPU to finish writing their pixel buffer */
+    std::vector<std::shared_ptr<capture_t>> reading;
+    wf::wl_timer<true> poll_timer;
+
+    /**
+     * Copy the buffer into a pixel buffer object. This only queues the copy on
+     * the GPU, the pixels are mapped once the fence after it is signaled.
+     */
+    void start_gl_readback(std::shared_ptr<capture_t> cap, const wf::render_buffer_t& buffer)
+    {
+        GLint prev_read_fb = 0;
+        GL_CALL(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prev_read_fb));
+        GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, wf::gles::ensure_render_buffer_fb_id(buffer)));
+
+        GL_CALL(glGenBuffers(1, &cap->pbo));
+        GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, cap->pbo));
+        GL_CALL(glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)cap->width * cap->height * 4,
+            nullptr, GL_STREAM_READ));
+        GL_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 4));
+        GL_CALL(glReadPixels(0, 0, cap->width, cap->height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        cap->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        GL_CALL(glFlush());
+
+        GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+        GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, prev_read_fb));
+
+        reading.push_back(std::move(cap));
+        if (!poll_timer.is_connected())
+        {
+            poll_timer.set_timeout(1, [=] { return poll_readbacks(); });
+        }
+    }
+
+    /* @return Whether there are still readbacks in progress */
+    bool poll_readbacks()
+    {
+        if (!wf::gles::ensure_context(false))
+        {
+            return false;
+        }
+
+        auto done = std::stable_partition(reading.begin(), reading.end(), [] (auto& cap)
+        {
+            return glClientWaitSync(cap->fence, 0, 0) == GL_TIMEOUT_EXPIRED;
+        });
+
+        std::vector<std::shared_ptr<capture_t>> ready(done, reading.end());
+        reading.erase(done, reading.end());
+        for (auto& cap : ready)
+        {
+            const size_t size = (size_t)cap->width * cap->height * 4;
+            GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, cap->pbo));
+            auto data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+            if (data)
+            {
+                auto bytes = (const uint8_t*)data;
+                cap->pixels.assign(bytes, bytes + size);
+                GL_CALL(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+            }
+
+            GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+            GL_CALL(glDeleteSync(cap->fence));
+            GL_CALL(glDeleteBuffers(1, &cap->pbo));
+
+            if (data)
+            {
+                encode(cap);
+            } else
+            {
+                LOGE("failed to map the pixels of capture ", cap->name);
+                finish(cap);
+            }
+        }
+
+        return !reading.empty();
+    }
+
+    void encode(std::shared_ptr<capture_t> cap)
+    {
+        worker_pool.submit([cap]
+        {
+            cap->ok = writers.at(cap->type)(cap->name.c_str(), cap->pixels.data(),
+                cap->width, cap->height, false);
+            cap->pixels = {};
+        }, [this, cap]
+        {
+            finish(cap);
+        });
+    }
+
+    void finish(std::shared_ptr<capture_t> cap)
+    {
+        --stats.pending;
+        ++(cap->ok ? stats.written : stats.failed);
+        if (cap->callback)
+        {
+            cap->callback(cap->ok);
+        }
+    }
+};
+
+capture_queue_t capture_queue;
+}
+
+bool capture_to_file(const wf::render_buffer_t& buffer, std::string name, std::string type,
+    capture_callback_t callback)
+{
+    return capture_queue.capture(buffer, std::move(name), std::move(type), std::move(callback));
+}
+
+capture_stats_t get_capture_stats()
+{
+    return capture_queue.stats;
 }
 
 void init()
 {
     LOGD("init ImageIO");
 #ifdef BUILD_WITH_IMAGEIO
-    loaders["png"] = Loader(texture_from_png);
-    loaders["jpg"] = Loader(texture_from_jpeg);
+    loaders["png"] = Loader(decode_png);
+    loaders["jpg"] = Loader(decode_jpeg);
     writers["png"] = Writer(texture_to_png);
 #endif
+    writers["qoi"] = Writer(texture_to_qoi);
+    writers["raw"] = Writer(texture_to_raw);
+}
+
+void fini()
+{
+    capture_queue.stop();
+    worker_pool.stop();
 }
 }
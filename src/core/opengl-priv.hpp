@@ -15,6 +15,14 @@ void bind_output(uint32_t fb);
 /** Indicate the output frame has been finished */
 void unbind_output();
 
+/**
+ * Append the vertices of the quads to @vertices, as used by
+ * render_textured_quads(): two triangles per quad, each vertex with its
+ * position and texture coordinates.
+ */
+void append_textured_quad_vertices(const std::vector<textured_quad_t>& quads, uint32_t bits,
+    std::vector<GLfloat>& vertices);
+
 /** Debugging: if GL_CALL experiences an error, exit immediately and print stacktrace. */
 extern bool exit_on_gles_error;
 }
@@ -1,5 +1,7 @@
 #include <wayfire/util/log.hpp>
+#include <deque>
 #include <map>
+#include <unordered_map>
 #include "opengl-priv.hpp"
 #include "wayfire/dassert.hpp"
 #include "wayfire/geometry.hpp"
@@ -126,12 +128,65 @@ void init()
     });
 }
 
+/**
+ * A buffer object through which the vertices of the built-in textured quads are
+ * streamed. Data is appended after the data of the previous draws, and when the
+ * buffer is full, its storage is orphaned so that the driver does not have to
+ * wait for pending draws which still read from it.
+ */
+struct stream_buffer_t
+{
+    GLuint id = 0;
+    size_t capacity = 64 * 1024;
+    size_t offset   = 0;
+
+    /**
+     * Upload the given data and leave the buffer bound to GL_ARRAY_BUFFER.
+     *
+     * @return The offset of the data in the buffer.
+     */
+    size_t upload(const void *data, size_t size)
+    {
+        if (!id)
+        {
+            GL_CALL(glGenBuffers(1, &id));
+        }
+
+        GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, id));
+        if ((offset == 0) || (offset + size > capacity))
+        {
+            capacity = std::max(capacity, size);
+            GL_CALL(glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW));
+            offset = 0;
+        }
+
+        GL_CALL(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+        size_t result = offset;
+        offset += size;
+        return result;
+    }
+
+    void free()
+    {
+        if (id)
+        {
+            GL_CALL(glDeleteBuffers(1, &id));
+        }
+
+        id     = 0;
+        offset = 0;
+    }
+};
+
+static stream_buffer_t stream_buffer;
+
 void fini()
 {
     wf::gles::run_in_context_if_gles([&]
     {
         program.free_resources();
         color_program.free_resources();
+        stream_buffer.free();
     });
 }
 
@@ -152,25 +207,16 @@ void unbind_output()
 
 bool exit_on_gles_error = false;
 
-std::vector<GLfloat> vertexData;
-std::vector<GLfloat> coordData;
-
-void render_transformed_texture(wf::gles_texture_t tex,
-    const gl_geometry& g, const gl_geometry& texg,
-    glm::mat4 model, glm::vec4 color, uint32_t bits)
-{
-    // We don't expect any errors from us!
-    disable_gl_call = true;
-
-    program.use(tex.type);
+static const name_id_t position_id{"position"};
+static const name_id_t uv_position_id{"uvPosition"};
+static const name_id_t mvp_id{"MVP"};
+static const name_id_t color_id{"color"};
 
-    vertexData = {
-        g.x1, g.y2,
-        g.x2, g.y2,
-        g.x2, g.y1,
-        g.x1, g.y1,
-    };
+/* Each vertex of a textured quad has a position and texture coordinates. */
+static constexpr int QUAD_VERTEX_FLOATS = 4;
 
+static gl_geometry get_texture_coords(const gl_geometry& texg, uint32_t bits)
+{
     gl_geometry final_texg = (bits & TEXTURE_USE_TEX_GEOMETRY) ?
         texg : gl_geometry{0.0f, 0.0f, 1.0f, 1.0f};
 
@@ -186,22 +232,50 @@ void render_transformed_texture(wf::gles_texture_t tex,
         final_texg.x2 = 1.0 - final_texg.x2;
     }
 
-    coordData = {
-        final_texg.x1, final_texg.y1,
-        final_texg.x2, final_texg.y1,
-        final_texg.x2, final_texg.y2,
-        final_texg.x1, final_texg.y2,
-    };
+    return final_texg;
+}
 
+/**
+ * Use the default program with the given texture and uniforms, and point its
+ * attributes to the given vertices, which are uploaded to the stream buffer.
+ */
+static void setup_textured_draw(const wf::gles_texture_t& tex,
+    const GLfloat *vertices, size_t nr_vertices, glm::mat4 model, glm::vec4 color)
+{
+    program.use(tex.type);
     program.set_active_texture(tex);
-    program.attrib_pointer("position", 2, 0, vertexData.data());
-    program.attrib_pointer("uvPosition", 2, 0, coordData.data());
-    program.uniformMatrix4f("MVP", model);
-    program.uniform4f("color", color);
+
+    const size_t stride = QUAD_VERTEX_FLOATS * sizeof(GLfloat);
+    const size_t offset = stream_buffer.upload(vertices, nr_vertices * stride);
+    program.attrib_pointer(position_id, 2, stride, (const void*)offset);
+    program.attrib_pointer(uv_position_id, 2, stride, (const void*)(offset + 2 * sizeof(GLfloat)));
+    // The attribute pointers keep referring to the stream buffer, but other
+    // code may use client-side arrays.
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+    program.uniformMatrix4f(mvp_id, model);
+    program.uniform4f(color_id, color);
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+}
 
+void render_transformed_texture(wf::gles_texture_t tex,
+    const gl_geometry& g, const gl_geometry& texg,
+    glm::mat4 model, glm::vec4 color, uint32_t bits)
+{
+    // We don't expect any errors from us!
+    disable_gl_call = true;
+
+    auto t = get_texture_coords(texg, bits);
+    const GLfloat vertices[] = {
+        g.x1, g.y2, t.x1, t.y1,
+        g.x2, g.y2, t.x2, t.y1,
+        g.x2, g.y1, t.x2, t.y2,
+        g.x1, g.y1, t.x1, t.y2,
+    };
+
+    setup_textured_draw(tex, vertices, 4, model, color);
     if (bits & RENDER_FLAG_CACHED)
     {
         return;
@@ -211,6 +285,48 @@ void render_transformed_texture(wf::gles_texture_t tex,
     clear_cached();
 }
 
+void append_textured_quad_vertices(const std::vector<textured_quad_t>& quads, uint32_t bits,
+    std::vector<GLfloat>& vertices)
+{
+    for (const auto& quad : quads)
+    {
+        const auto& g = quad.geometry;
+        auto t = get_texture_coords(quad.texture_geometry, bits);
+
+        // Two triangles per quad, since separate fans cannot be drawn at once
+        vertices.insert(vertices.end(), {
+            g.x1, g.y2, t.x1, t.y1,
+            g.x2, g.y2, t.x2, t.y1,
+            g.x2, g.y1, t.x2, t.y2,
+            g.x1, g.y2, t.x1, t.y1,
+            g.x2, g.y1, t.x2, t.y2,
+            g.x1, g.y1, t.x1, t.y2,
+        });
+    }
+}
+
+void render_textured_quads(wf::gles_texture_t tex,
+    const std::vector<textured_quad_t>& quads,
+    glm::mat4 model, glm::vec4 color, uint32_t bits)
+{
+    if (quads.empty())
+    {
+        return;
+    }
+
+    disable_gl_call = true;
+
+    // Kept between calls so that its capacity is reused
+    static std::vector<GLfloat> vertices;
+    vertices.clear();
+    append_textured_quad_vertices(quads, bits, vertices);
+
+    const size_t nr_vertices = vertices.size() / QUAD_VERTEX_FLOATS;
+    setup_textured_draw(tex, vertices.data(), nr_vertices, model, color);
+    GL_CALL(glDrawArrays(GL_TRIANGLES, 0, nr_vertices));
+    clear_cached();
+}
+
 void draw_cached()
 {
     GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
@@ -258,9 +374,9 @@ void render_rectangle(wf::geometry_t geometry, wf::color_t color,
         x, y,
     };
 
-    color_program.attrib_pointer("position", 2, 0, vertexData);
-    color_program.uniformMatrix4f("MVP", matrix);
-    color_program.uniform4f("color", {color.r, color.g, color.b, color.a});
+    color_program.attrib_pointer(position_id, 2, 0, vertexData);
+    color_program.uniformMatrix4f(mvp_id, matrix);
+    color_program.uniform4f(color_id, {color.r, color.g, color.b, color.a});
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
@@ -510,45 +626,90 @@ class program_t::impl
     int active_program_idx = 0;
 
     int id[wf::TEXTURE_TYPE_ALL];
-    std::unordered_map<std::string, int> uniforms[wf::TEXTURE_TYPE_ALL];
 
-    /** Find the uniform location for the currently bound program */
-    int find_uniform_loc(const std::string& name)
+    /* Locations indexed by name_id_t::index, LOCATION_UNKNOWN if not queried yet */
+    static constexpr int LOCATION_UNKNOWN = -2;
+    std::vector<int> uniforms[wf::TEXTURE_TYPE_ALL];
+    std::vector<int> attribs[wf::TEXTURE_TYPE_ALL];
+
+    static int& cached_location(std::vector<int>& cache, const name_id_t& name)
     {
-        auto it = uniforms[active_program_idx].find(name);
-        if (it != uniforms[active_program_idx].end())
+        if (name.index >= cache.size())
         {
-            return it->second;
+            cache.resize(name.index + 1, LOCATION_UNKNOWN);
         }
 
-        uniforms[active_program_idx][name] =
-            GL_CALL(glGetUniformLocation(id[active_program_idx], name.c_str()));
+        return cache[name.index];
+    }
 
-        if (uniforms[active_program_idx][name] == -1)
+    /** Find the uniform location for the currently bound program */
+    int find_uniform_loc(const name_id_t& name)
+    {
+        int& loc = cached_location(uniforms[active_program_idx], name);
+        if (loc == LOCATION_UNKNOWN)
         {
-            LOGE("Uniform ", name, " not found in program");
+            loc = GL_CALL(glGetUniformLocation(id[active_program_idx], name.get_name().c_str()));
+            if (loc == -1)
+            {
+                LOGE("Uniform ", name.get_name(), " not found in program");
+            }
         }
 
-        return uniforms[active_program_idx][name];
+        return loc;
     }
 
-    std::map<std::string, int> attribs[wf::TEXTURE_TYPE_ALL];
     /** Find the attrib location for the currently bound program */
-    int find_attrib_loc(const std::string& name)
+    int find_attrib_loc(const name_id_t& name)
     {
-        auto it = attribs[active_program_idx].find(name);
-        if (it != attribs[active_program_idx].end())
+        int& loc = cached_location(attribs[active_program_idx], name);
+        if (loc == LOCATION_UNKNOWN)
         {
-            return it->second;
+            loc = GL_CALL(glGetAttribLocation(id[active_program_idx], name.get_name().c_str()));
         }
 
-        attribs[active_program_idx][name] =
-            GL_CALL(glGetAttribLocation(id[active_program_idx], name.c_str()));
-
-        return attribs[active_program_idx][name];
+        return loc;
     }
 };
 
+namespace
+{
+struct name_registry_t
+{
+    std::unordered_map<std::string, uint32_t> ids;
+    // A deque, so that references to the names stay valid
+    std::deque<std::string> names;
+};
+
+name_registry_t& get_name_registry()
+{
+    static name_registry_t registry;
+    return registry;
+}
+
+uint32_t intern_name(const std::string& name)
+{
+    auto& registry = get_name_registry();
+    auto it = registry.ids.find(name);
+    if (it != registry.ids.end())
+    {
+        return it->second;
+    }
+
+    uint32_t index = registry.names.size();
+    registry.names.push_back(name);
+    registry.ids[name] = index;
+    return index;
+}
+}
+
+name_id_t::name_id_t(const std::string& name) : index(intern_name(name))
+{}
+
+const std::string& name_id_t::get_name() const
+{
+    return get_name_registry().names[index];
+}
+
 program_t::program_t()
 {
     this->priv = std::make_unique<impl>();
@@ -644,36 +805,66 @@ int program_t::get_program_id(wf::texture_type_t type)
 }
 
 void program_t::uniform1i(const std::string& name, int value)
+{
+    uniform1i(name_id_t{name}, value);
+}
+
+void program_t::uniform1i(const name_id_t& name, int value)
 {
     int loc = priv->find_uniform_loc(name);
     GL_CALL(glUniform1i(loc, value));
 }
 
 void program_t::uniform1f(const std::string& name, float value)
+{
+    uniform1f(name_id_t{name}, value);
+}
+
+void program_t::uniform1f(const name_id_t& name, float value)
 {
     int loc = priv->find_uniform_loc(name);
     GL_CALL(glUniform1f(loc, value));
 }
 
 void program_t::uniform2f(const std::string& name, float x, float y)
+{
+    uniform2f(name_id_t{name}, x, y);
+}
+
+void program_t::uniform2f(const name_id_t& name, float x, float y)
 {
     int loc = priv->find_uniform_loc(name);
     GL_CALL(glUniform2f(loc, x, y));
 }
 
 void program_t::uniform3f(const std::string& name, float x, float y, float z)
+{
+    uniform3f(name_id_t{name}, x, y, z);
+}
+
+void program_t::uniform3f(const name_id_t& name, float x, float y, float z)
 {
     int loc = priv->find_uniform_loc(name);
     GL_CALL(glUniform3f(loc, x, y, z));
 }
 
 void program_t::uniform4f(const std::string& name, const glm::vec4& value)
+{
+    uniform4f(name_id_t{name}, value);
+}
+
+void program_t::uniform4f(const name_id_t& name, const glm::vec4& value)
 {
     int loc = priv->find_uniform_loc(name);
     GL_CALL(glUniform4f(loc, value.r, value.g, value.b, value.a));
 }
 
 void program_t::uniformMatrix4f(const std::string& name, const glm::mat4& value)
+{
+    uniformMatrix4f(name_id_t{name}, value);
+}
+
+void program_t::uniformMatrix4f(const name_id_t& name, const glm::mat4& value)
 {
     int loc = priv->find_uniform_loc(name);
     GL_CALL(glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]));
@@ -681,6 +872,12 @@ void program_t::uniformMatrix4f(const std::string& name, const glm::mat4& value)
 
 void program_t::attrib_pointer(const std::string& attrib,
     int size, int stride, const void *ptr, GLenum type)
+{
+    attrib_pointer(name_id_t{attrib}, size, stride, ptr, type);
+}
+
+void program_t::attrib_pointer(const name_id_t& attrib,
+    int size, int stride, const void *ptr, GLenum type)
 {
     int loc = priv->find_attrib_loc(attrib);
     priv->active_attrs.insert(loc);
@@ -691,7 +888,7 @@ void program_t::attrib_pointer(const std::string& attrib,
 
 void program_t::attrib_divisor(const std::string& attrib, int divisor)
 {
-    int loc = priv->find_attrib_loc(attrib);
+    int loc = priv->find_attrib_loc(name_id_t{attrib});
     priv->active_attrs_divisors.insert(loc);
     GL_CALL(glVertexAttribDivisor(loc, divisor));
 }
@@ -719,8 +916,10 @@ void program_t::set_active_texture(const wf::gles_texture_t& texture)
         base.y   = 1.0 - base.y;
     }
 
-    uniform2f("_wayfire_uv_base", base.x, base.y);
-    uniform2f("_wayfire_uv_scale", scale.x, scale.y);
+    static const name_id_t uv_base_id{"_wayfire_uv_base"};
+    static const name_id_t uv_scale_id{"_wayfire_uv_scale"};
+    uniform2f(uv_base_id, base.x, base.y);
+    uniform2f(uv_scale_id, scale.x, scale.y);
 }
 
 void program_t::deactivate()
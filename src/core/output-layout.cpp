@@ -18,6 +18,7 @@
 #include <xf86drmMode.h>
 
 #include <wayfire/debug.hpp>
+#include <wayfire/nonstd/tracking-allocator.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 #include <wayfire/util/log.hpp>
 
@@ -240,9 +241,12 @@ void transfer_views(wf::output_t *from, wf::output_t *to) {
   // Step 2: Ensure none of the remaining views have an invalid output.
   // Note that all views in workspace sets will have their output reassigned
   // automatically by the workspace-set impl.
+  // Views are only collected here, nothing is freed while iterating. Null
+  // entries are left by views freed during a for_each() this may run from.
   std::vector<std::shared_ptr<wf::view_interface_t>> non_ws_views;
-  for (auto &view : wf::get_core().get_all_views()) {
-    if ((view->get_output() == from) &&
+  for (auto &view :
+       wf::tracking_allocator_t<wf::view_interface_t>::get().get_all()) {
+    if (view && (view->get_output() == from) &&
         (!toplevel_cast(view) || !toplevel_cast(view)->get_wset())) {
       // Take a ref, so that the view doesn't get destroyed while we're doing
       // operations on the views
@@ -2,11 +2,16 @@
 #include <algorithm>
 #include <memory>
 #include <filesystem>
+#include <thread>
+#include <atomic>
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "config.h"
 #include "plugin-loader.hpp"
 #include "../core/wm.hpp"
+#include "core-impl.hpp"
 #include "wayfire/plugin.hpp"
 #include <wayfire/util/log.hpp>
 
@@ -79,63 +84,75 @@ void wf::plugin_manager_t::destroy_plugin(wf::loaded_plugin_t& p)
     }
 }
 
-static bool check_plugin_api_version(const std::string& path, bool can_unload_so)
+static bool check_plugin_api_version(void *handle, const std::string& path)
 {
-    // First, open everything just locally and in a lazy way.
-    // We want to check just the API/ABI version.
-    // If we load with RTLD_NOW, if the API/ABI version is wrong, we may get a crash just by
-    // dlopen()-ing the plugin.
-    void *handle = dlopen(path.c_str(), RTLD_LOCAL | RTLD_LAZY);
-    if (handle == NULL)
-    {
-        LOGE("error loading plugin [", path, "]: ", dlerror());
-        return false;
-    }
-
     /* Check plugin version */
     auto version_func_ptr = dlsym(handle, "getWayfireVersion");
     if (version_func_ptr == NULL)
     {
-        LOGE(path, ": missing getWayfireVersion()", path.c_str());
-        dlclose(handle);
+        LOGE(path, ": missing getWayfireVersion()");
         return false;
     }
 
     auto version_func = wf::union_cast<void*, wayfire_plugin_version_func>(version_func_ptr);
     int32_t plugin_abi_version = version_func();
 
-    if (version_func() != WAYFIRE_API_ABI_VERSION)
+    if (plugin_abi_version != WAYFIRE_API_ABI_VERSION)
     {
         LOGE(path, ": API/ABI version mismatch: Wayfire is ",
             WAYFIRE_API_ABI_VERSION, ",  plugin built with ", plugin_abi_version);
-        dlclose(handle);
         return false;
     }
 
-    if (can_unload_so)
-    {
-        dlclose(handle);
-    }
-
     return true;
 }
 
-std::pair<void*, void*> wf::get_new_instance_handle(const std::string& path, bool can_unload_so)
+std::pair<void*, void*> wf::get_new_instance_handle(const std::string& path, bool can_unload_so,
+    bool *version_ok)
 {
-    if (!check_plugin_api_version(path, can_unload_so))
+    if (version_ok)
+    {
+        *version_ok = true;
+    }
+
+    // First, open everything just locally, so that the API/ABI version can be checked before the
+    // plugin's symbols become visible to other plugins. The symbols are bound immediately: promoting
+    // the object with RTLD_NOW below does not bind an already mapped object again, and plugins with
+    // unresolved symbols should fail here instead of crashing at the first call.
+    void *local_handle = dlopen(path.c_str(), RTLD_LOCAL | RTLD_NOW);
+    if (local_handle == NULL)
+    {
+        LOGE("error loading plugin [", path, "]: ", dlerror());
+        return {nullptr, nullptr};
+    }
+
+    if (!check_plugin_api_version(local_handle, path))
     {
+        if (version_ok)
+        {
+            *version_ok = false;
+        }
+
+        dlclose(local_handle);
         return {nullptr, nullptr};
     }
 
-    // RTLD_GLOBAL is required for RTTI/dynamic_cast across plugins
-    void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_GLOBAL);
+    // RTLD_GLOBAL is required for RTTI/dynamic_cast across plugins.
+    // The object is already mapped, so with RTLD_NOLOAD this only promotes it to the global namespace
+    // instead of mapping and relocating the file a second time.
+    void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_GLOBAL | RTLD_NOLOAD);
+    // The promoted handle holds its own reference, so that destroy_plugin() needs a single dlclose().
+    if (can_unload_so)
+    {
+        dlclose(local_handle);
+    }
+
     if (handle == NULL)
     {
         LOGE("error loading plugin [", path, "]: ", dlerror());
         return {nullptr, nullptr};
     }
 
-    /* Check plugin version */
     auto new_instance_func_ptr = dlsym(handle, "newInstance");
     if (new_instance_func_ptr == NULL)
     {
@@ -149,9 +166,84 @@ std::pair<void*, void*> wf::get_new_instance_handle(const std::string& path, boo
     return {handle, new_instance_func_ptr};
 }
 
+void wf::prefetch_plugin_files(const std::vector<std::string>& paths)
+{
+    if (paths.empty())
+    {
+        return;
+    }
+
+    std::atomic<size_t> next_path{0};
+    auto prefetch_worker = [&] ()
+    {
+        std::vector<char> buffer(1 << 16);
+        for (size_t i = next_path++; i < paths.size(); i = next_path++)
+        {
+            int fd = open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                continue;
+            }
+
+            // Start readahead for the whole file, then touch it so that it is in the page cache
+            // once the main thread dlopen()s it.
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            while (read(fd, buffer.data(), buffer.size()) > 0)
+            {}
+
+            close(fd);
+        }
+    };
+
+    size_t nr_workers = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 8);
+    nr_workers = std::min(nr_workers, paths.size());
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < nr_workers; i++)
+    {
+        workers.emplace_back(prefetch_worker);
+    }
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+bool wf::plugin_manager_t::is_known_incompatible(const std::string& path)
+{
+    auto it = api_check_cache.find(path);
+    if (it == api_check_cache.end())
+    {
+        return false;
+    }
+
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec || (mtime != it->second.mtime))
+    {
+        // The plugin was rebuilt or removed, check again.
+        api_check_cache.erase(it);
+        return false;
+    }
+
+    return !it->second.compatible;
+}
+
 std::optional<wf::loaded_plugin_t> wf::plugin_manager_t::load_plugin_from_file(std::string path)
 {
-    auto [handle, new_instance_func_ptr] = wf::get_new_instance_handle(path, enable_so_unloading);
+    auto start = std::chrono::steady_clock::now();
+    bool version_ok = true;
+    auto [handle, new_instance_func_ptr] = wf::get_new_instance_handle(path, enable_so_unloading,
+        &version_ok);
+
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (!ec)
+    {
+        api_check_cache[path] = plugin_api_check_t{mtime, version_ok};
+    }
+
     if (new_instance_func_ptr)
     {
         auto new_instance_func = union_cast<void*, wayfire_plugin_load_func>(new_instance_func_ptr);
@@ -161,6 +253,8 @@ std::optional<wf::loaded_plugin_t> wf::plugin_manager_t::load_plugin_from_file(s
             lp.instance  = std::unique_ptr<wf::plugin_interface_t>(new_instance_func());
             lp.so_handle = handle;
             lp.so_path   = path;
+            lp.load_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
             return lp;
         } catch (...)
         {
@@ -240,15 +334,29 @@ void wf::plugin_manager_t::reload_dynamic_plugins()
     }
 
     /* load new plugins */
-    std::vector<std::pair<std::string, wf::loaded_plugin_t>> pending_initialize;
-
-    for (auto plugin : next_plugins)
+    std::vector<std::string> to_load;
+    for (auto& plugin : next_plugins)
     {
         if (loaded_plugins.count(plugin))
         {
             continue;
         }
 
+        if (is_known_incompatible(plugin))
+        {
+            LOGE("Skipping plugin ", plugin, ": API/ABI version mismatch");
+            continue;
+        }
+
+        to_load.push_back(plugin);
+    }
+
+    // dlopen() itself is serialized by the dynamic loader, but reading the files is not.
+    prefetch_plugin_files(to_load);
+
+    std::vector<std::pair<std::string, wf::loaded_plugin_t>> pending_initialize;
+    for (auto& plugin : to_load)
+    {
         std::optional<wf::loaded_plugin_t> ptr = load_plugin_from_file(plugin);
         if (ptr)
         {
@@ -261,19 +369,32 @@ void wf::plugin_manager_t::reload_dynamic_plugins()
         return a.second.instance->get_order_hint() < b.second.instance->get_order_hint();
     });
 
+    std::chrono::microseconds total_time{0};
     for (auto& [plugin, ptr] : pending_initialize)
     {
         try {
+            auto start = std::chrono::steady_clock::now();
             ptr.instance->init();
+            ptr.init_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+
+            LOGD("Plugin ", plugin, ": loaded in ", ptr.load_time.count(), "us, ",
+                "initialized in ", ptr.init_time.count(), "us");
+            total_time += ptr.load_time + ptr.init_time;
             loaded_plugins[plugin] = std::move(ptr);
         } catch (...)
         {
             // this will call fini(), the destructor and optionally unload the .so
             destroy_plugin(ptr);
-            LOGE("Failed to init plugin \"", plugin_name, "\". ");
+            LOGE("Failed to init plugin \"", plugin, "\". ");
         }
     }
 
+    if (!pending_initialize.empty())
+    {
+        LOGI("Loaded ", pending_initialize.size(), " plugins in ", total_time.count() / 1000, "ms");
+    }
+
     is_loading = false;
 }
 
@@ -284,7 +405,11 @@ static wf::loaded_plugin_t create_plugin(std::string name)
     lp.instance  = std::make_unique<T>();
     lp.so_handle = nullptr;
     lp.so_path   = name;
+
+    auto start = std::chrono::steady_clock::now();
     lp.instance->init();
+    lp.init_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
     return lp;
 }
 
@@ -295,6 +420,37 @@ void wf::plugin_manager_t::load_static_plugins()
     loaded_plugins["_close"] = create_plugin<wf::per_output_plugin_t<wayfire_close>>("_close");
 }
 
+std::vector<wf::plugin_load_stats_t> wf::plugin_manager_t::get_load_stats() const
+{
+    std::vector<plugin_load_stats_t> stats;
+    for (auto& [name, plugin] : loaded_plugins)
+    {
+        plugin_load_stats_t entry;
+        entry.name    = name;
+        entry.load_us = plugin.load_time.count();
+        entry.init_us = plugin.init_time.count();
+        stats.push_back(entry);
+    }
+
+    std::sort(stats.begin(), stats.end(), [] (const auto& a, const auto& b)
+    {
+        return a.init_us > b.init_us;
+    });
+
+    return stats;
+}
+
+std::vector<wf::plugin_load_stats_t> wf::get_plugin_load_stats()
+{
+    auto& core = wf::get_core_impl();
+    if (!core.plugin_mgr)
+    {
+        return {};
+    }
+
+    return core.plugin_mgr->get_load_stats();
+}
+
 std::vector<std::string> wf::get_plugin_paths()
 {
     std::vector<std::string> plugin_prefixes;
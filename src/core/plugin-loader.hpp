@@ -1,10 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <chrono>
 #include <unordered_map>
 #include "wayfire/plugin.hpp"
 #include "wayfire/util.hpp"
 #include <wayfire/option-wrapper.hpp>
+#include <filesystem>
 
 namespace wf
 {
@@ -18,6 +20,20 @@ struct loaded_plugin_t
 
     // A path to the .so file of the plugin.
     std::string so_path;
+
+    // Time spent in dlopen() and newInstance(), and in init() respectively.
+    std::chrono::microseconds load_time{0};
+    std::chrono::microseconds init_time{0};
+};
+
+/**
+ * Result of a (cached) check of a plugin's API/ABI version.
+ * The cache is keyed by the path of the plugin and invalidated when the file changes.
+ */
+struct plugin_api_check_t
+{
+    std::filesystem::file_time_type mtime;
+    bool compatible;
 };
 
 struct plugin_manager_t
@@ -32,14 +48,19 @@ struct plugin_manager_t
         return is_loading;
     }
 
+    /** Get load/init timings of all currently loaded plugins. */
+    std::vector<plugin_load_stats_t> get_load_stats() const;
+
   private:
     wf::option_wrapper_t<std::string> plugins_opt;
     wf::option_wrapper_t<bool> enable_so_unloading;
     std::unordered_map<std::string, loaded_plugin_t> loaded_plugins;
+    std::unordered_map<std::string, plugin_api_check_t> api_check_cache;
 
     void deinit_plugins(bool unloadable);
 
     std::optional<loaded_plugin_t> load_plugin_from_file(std::string path);
+    bool is_known_incompatible(const std::string& path);
     void load_static_plugins();
     void destroy_plugin(loaded_plugin_t& plugin);
 
@@ -65,9 +86,22 @@ B union_cast(A object)
  * On success, return the handle from dlopen() and the pointer to the
  * newInstance of the plugin.
  *
+ * The file is opened only once: it is first mapped locally to check the
+ * API/ABI version, and then promoted to the global namespace.
+ *
+ * @param version_ok Optional, set to false if the plugin was rejected because
+ *   of a missing or mismatched version.
+ *
  * @return (dlopen() handle, newInstance pointer)
  */
-std::pair<void*, void*> get_new_instance_handle(const std::string& path, bool can_unload_so);
+std::pair<void*, void*> get_new_instance_handle(const std::string& path, bool can_unload_so,
+    bool *version_ok = nullptr);
+
+/**
+ * Read the given plugin files in parallel worker threads, so that the following
+ * dlopen() calls on the main thread find them in the page cache.
+ */
+void prefetch_plugin_files(const std::vector<std::string>& paths);
 
 /**
  * List the locations where wayfire's plugins are installed.
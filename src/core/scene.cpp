@@ -1,5 +1,9 @@
+#include <cmath>
 #include <limits>
 #include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
 #include <wayfire/scene.hpp>
 #include <wayfire/view.hpp>
 #include <wayfire/output.hpp>
@@ -122,10 +126,140 @@ bool floating_inner_node_t::set_children_list(std::vector<node_ptr> new_list)
     return true;
 }
 
+static restack_stats_t restack_stats;
+
+restack_stats_t get_restack_stats()
+{
+    return restack_stats;
+}
+
+/**
+ * Compute the region which changes when the list of children changes from
+ * @old_list to @new_list, in the coordinate system of the children.
+ *
+ * Added and removed children are damaged completely. Children which stay but
+ * change their order only change where they overlap the siblings they were
+ * moved past, so for raising a view, only the parts of it which were covered
+ * are damaged.
+ */
+static wf::region_t get_children_list_damage(const std::vector<node_ptr>& old_list,
+    const std::vector<node_ptr>& new_list, bool& restacked)
+{
+    wf::region_t damage;
+    std::unordered_map<node_t*, size_t> new_index;
+    for (size_t i = 0; i < new_list.size(); i++)
+    {
+        new_index[new_list[i].get()] = i;
+    }
+
+    // The children present in both lists, in their old order, with their new index.
+    std::vector<std::pair<node_t*, size_t>> kept;
+    std::unordered_set<node_t*> old_nodes;
+    for (auto& node : old_list)
+    {
+        old_nodes.insert(node.get());
+        auto it = new_index.find(node.get());
+        if (it != new_index.end())
+        {
+            kept.push_back({node.get(), it->second});
+        } else if (node->is_enabled())
+        {
+            damage |= node->get_bounding_box();
+        }
+    }
+
+    for (auto& node : new_list)
+    {
+        if (!old_nodes.count(node.get()) && node->is_enabled())
+        {
+            damage |= node->get_bounding_box();
+        }
+    }
+
+    // The children whose order changed form a contiguous range in the old order,
+    // the ones before and after it keep their place.
+    std::vector<size_t> sorted_index(kept.size());
+    for (size_t i = 0; i < kept.size(); i++)
+    {
+        sorted_index[i] = kept[i].second;
+    }
+
+    std::sort(sorted_index.begin(), sorted_index.end());
+    size_t first = 0, last = kept.size();
+    while ((first < last) && (kept[first].second == sorted_index[first]))
+    {
+        ++first;
+    }
+
+    while ((last > first) && (kept[last - 1].second == sorted_index[last - 1]))
+    {
+        --last;
+    }
+
+    restacked = (first < last);
+    std::vector<std::optional<wf::geometry_t>> boxes(last - first);
+    for (size_t i = first; i < last; i++)
+    {
+        if (kept[i].first->is_enabled())
+        {
+            boxes[i - first] = kept[i].first->get_bounding_box();
+        }
+    }
+
+    for (size_t i = first; i < last; i++)
+    {
+        for (size_t j = i + 1; j < last; j++)
+        {
+            auto& a = boxes[i - first];
+            auto& b = boxes[j - first];
+            if ((kept[i].second > kept[j].second) && a && b && (*a & *b))
+            {
+                damage |= wf::geometry_intersection(*a, *b);
+            }
+        }
+    }
+
+    return damage;
+}
+
+/**
+ * Convert a region from the node's local coordinates to the coordinates of its
+ * parent, in which its damage is reported.
+ */
+static wf::region_t local_region_to_parent(node_t *node, const wf::region_t& region)
+{
+    wf::region_t result;
+    for (const auto& rect : region)
+    {
+        const wf::pointf_t corners[] = {
+            node->to_global(wf::pointf_t{(double)rect.x1, (double)rect.y1}),
+            node->to_global(wf::pointf_t{(double)rect.x2, (double)rect.y1}),
+            node->to_global(wf::pointf_t{(double)rect.x1, (double)rect.y2}),
+            node->to_global(wf::pointf_t{(double)rect.x2, (double)rect.y2}),
+        };
+
+        double x1 = corners[0].x, x2 = corners[0].x, y1 = corners[0].y, y2 = corners[0].y;
+        for (const auto& corner : corners)
+        {
+            x1 = std::min(x1, corner.x);
+            x2 = std::max(x2, corner.x);
+            y1 = std::min(y1, corner.y);
+            y2 = std::max(y2, corner.y);
+        }
+
+        result |= wf::geometry_t{
+            (int)std::floor(x1), (int)std::floor(y1),
+            (int)std::ceil(x2) - (int)std::floor(x1), (int)std::ceil(y2) - (int)std::floor(y1),
+        };
+    }
+
+    return result;
+}
+
 void node_t::set_children_unchecked(std::vector<node_ptr> new_list)
 {
-    node_damage_signal data;
-    data.region |= get_bounding_box();
+    bool restacked = false;
+    auto damage    = get_children_list_damage(this->children, new_list, restacked);
 
     for (auto& node : this->children)
     {
@@ -140,8 +274,21 @@ void node_t::set_children_unchecked(std::vector<node_ptr> new_list)
 
     this->children = std::move(new_list);
 
-    data.region |= get_bounding_box();
-    this->emit(&data);
+    node_damage_signal data;
+    data.region = local_region_to_parent(this, damage);
+    if (restacked)
+    {
+        restack_stats.restacks++;
+        for (const auto& rect : data.region)
+        {
+            restack_stats.damaged_pixels += uint64_t(rect.x2 - rect.x1) * (rect.y2 - rect.y1);
+        }
+    }
+
+    if (!data.region.empty())
+    {
+        this->emit(&data);
+    }
 }
 
 static int get_layer_index(const wf::scene::node_t *node)
@@ -19,7 +19,11 @@ wf::cursor_t::cursor_t(wf::seat_t *seat) {
   init_xcursor();
   init_cursor_shape_manager();
 
-  config_reloaded = [=](auto) { init_xcursor(); };
+  config_reloaded = [=](wf::reload_config_signal *ev) {
+    if (ev->section_changed("input")) {
+      init_xcursor();
+    }
+  };
 
   wf::get_core().connect(&config_reloaded);
 
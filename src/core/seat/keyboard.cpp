@@ -14,7 +14,15 @@
 #include <wayfire/util/log.hpp>
 
 void wf::keyboard_t::setup_listeners() {
-  on_config_reload = [=](auto) { reload_input_options(); };
+  on_config_reload = [=](wf::reload_config_signal *ev) {
+    // Keyboards may also use per-device input-device:<name> sections
+    auto it = ev->changed_sections.lower_bound("input");
+    bool input_changed = (it != ev->changed_sections.end()) &&
+                         (it->rfind("input", 0) == 0);
+    if (ev->full_reload || input_changed) {
+      reload_input_options();
+    }
+  };
   wf::get_core().connect(&on_config_reload);
 
   on_key.set_callback([&](void *data) {
@@ -88,6 +88,12 @@ struct seat_t::impl {
   void set_activated_view(wayfire_toplevel_view view);
 
   uint32_t last_press_release_serial = 0;
+
+  /* Activity is reported at most once per input/activity_notify_interval */
+  int64_t last_activity_notify = 0;
+  bool activity_pending = false;
+  wf::wl_timer<false> activity_timer;
+  void send_activity_notification();
 };
 } // namespace wf
 
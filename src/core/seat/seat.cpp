@@ -207,13 +207,36 @@ xkb_state *wf::seat_t::get_xkb_state() {
   return nullptr;
 }
 
-void wf::seat_t::notify_activity() {
+void wf::seat_t::impl::send_activity_notification() {
+  activity_pending = false;
+  last_activity_notify = wf::get_current_time();
   wlr_idle_notifier_v1_notify_activity(wf::get_core().protocols.idle_notifier,
-                                       this->seat);
+                                       seat);
   seat_activity_signal data;
   wf::get_core().emit(&data);
 }
 
+void wf::seat_t::notify_activity() {
+  static wf::option_wrapper_t<int> interval{"input/activity_notify_interval"};
+
+  // The first event after a pause is reported right away, so that idle
+  // clients resume immediately. Later events are folded into one trailing
+  // notification per interval.
+  int64_t elapsed = wf::get_current_time() - priv->last_activity_notify;
+  if (elapsed >= interval) {
+    priv->activity_timer.disconnect();
+    priv->send_activity_notification();
+    return;
+  }
+
+  if (!priv->activity_pending) {
+    priv->activity_pending = true;
+    priv->activity_timer.set_timeout(interval - elapsed, [this]() {
+      priv->send_activity_notification();
+    });
+  }
+}
+
 std::vector<uint32_t> wf::seat_t::get_pressed_keys() {
   std::vector<uint32_t> pressed_keys{priv->pressed_keys.begin(),
                                      priv->pressed_keys.end()};
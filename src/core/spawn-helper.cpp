@@ -0,0 +1,389 @@
+#include "spawn-helper.hpp"
+
+#include <wayfire/util/log.hpp>
+#include <wayland-server-core.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+/**
+ * A request is a single packet with the header, followed by the command and
+ * the environment entries, each terminated by a NUL byte.
+ */
+struct request_header_t
+{
+    uint64_t id;
+    uint32_t discard_output;
+    uint32_t nr_env;
+};
+
+struct reply_t
+{
+    uint64_t id;
+    pid_t pid;
+};
+
+/* Larger requests (i.e huge environments) fall back to fork() in core. */
+constexpr size_t MAX_REQUEST = 128 * 1024;
+
+/* How long spawn_sync() waits for the helper before giving up */
+constexpr auto SYNC_TIMEOUT = std::chrono::seconds(1);
+}
+
+static pid_t spawn_from_request(char *buf, size_t len)
+{
+    if ((len <= sizeof(request_header_t)) || (buf[len - 1] != '\0'))
+    {
+        return 0;
+    }
+
+    request_header_t header;
+    std::memcpy(&header, buf, sizeof(header));
+
+    char *end     = buf + len;
+    char *command = buf + sizeof(header);
+    std::vector<char*> envp;
+    for (char *it = command + strlen(command) + 1; (it < end) && (envp.size() < header.nr_env);
+         it += strlen(it) + 1)
+    {
+        envp.push_back(it);
+    }
+
+    envp.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (header.discard_output)
+    {
+        posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, 1, 2);
+    }
+
+    // The helper ignores SIGCHLD and the compositor ignores SIGPIPE, clients
+    // should start with the default dispositions and nothing blocked.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigaddset(&signals, SIGCHLD);
+    sigaddset(&signals, SIGPIPE);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    char sh[] = "/bin/sh";
+    char dash_c[] = "-c";
+    char *argv[]  = {sh, dash_c, command, nullptr};
+
+    pid_t pid = 0;
+    int ret   = posix_spawn(&pid, sh, &actions, &attr, argv, envp.data());
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    return ret == 0 ? pid : 0;
+}
+
+[[noreturn]] static void helper_main(int fd)
+{
+    // Started processes are reaped automatically instead of staying zombies.
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    std::vector<char> buf(MAX_REQUEST);
+    while (true)
+    {
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_TRUNC);
+        if ((len < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+
+        if (len <= 0)
+        {
+            // The compositor has exited.
+            _exit(0);
+        }
+
+        reply_t reply{};
+        if ((size_t)len >= sizeof(request_header_t))
+        {
+            std::memcpy(&reply.id, buf.data(), sizeof(reply.id));
+        }
+
+        if ((size_t)len <= buf.size())
+        {
+            reply.pid = spawn_from_request(buf.data(), len);
+        }
+
+        if (send(fd, &reply, sizeof(reply), MSG_NOSIGNAL) < 0)
+        {
+            _exit(0);
+        }
+    }
+}
+
+wf::spawn_helper_t::spawn_helper_t(std::function<bool()> child_setup)
+{
+    dispatch_idle.set_callback([=] { dispatch_deferred(); });
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) != 0)
+    {
+        LOGE("Failed to create the spawn helper socket: ", strerror(errno));
+        return;
+    }
+
+    helper_pid = fork();
+    if (helper_pid == 0)
+    {
+        close(fds[0]);
+        if (child_setup && !child_setup())
+        {
+            _exit(1);
+        }
+
+        helper_main(fds[1]);
+    }
+
+    close(fds[1]);
+    if (helper_pid < 0)
+    {
+        LOGE("Failed to fork the spawn helper: ", strerror(errno));
+        close(fds[0]);
+        return;
+    }
+
+    fd = fds[0];
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+wf::spawn_helper_t::~spawn_helper_t()
+{
+    stop();
+}
+
+void wf::spawn_helper_t::attach(wl_event_loop *loop)
+{
+    if (is_running() && !event_source)
+    {
+        event_source = wl_event_loop_add_fd(loop, fd, WL_EVENT_READABLE, handle_readable, this);
+    }
+}
+
+bool wf::spawn_helper_t::is_running() const
+{
+    return fd >= 0;
+}
+
+void wf::spawn_helper_t::stop()
+{
+    dispatch_idle.disconnect();
+    if (event_source)
+    {
+        wl_event_source_remove(event_source);
+        event_source = nullptr;
+    }
+
+    if (fd >= 0)
+    {
+        // The helper exits once it sees the socket closed.
+        close(fd);
+        fd = -1;
+    }
+
+    if (helper_pid > 0)
+    {
+        waitpid(helper_pid, nullptr, 0);
+        helper_pid = -1;
+    }
+}
+
+bool wf::spawn_helper_t::send_request(uint64_t id, const std::string& command,
+    const std::vector<std::string>& env, bool discard_output)
+{
+    request_header_t header;
+    header.id = id;
+    header.discard_output = discard_output;
+    header.nr_env = env.size();
+
+    std::string buf{(const char*)&header, sizeof(header)};
+    buf.append(command.c_str(), command.size() + 1);
+    for (auto& entry : env)
+    {
+        buf.append(entry.c_str(), entry.size() + 1);
+    }
+
+    if (buf.size() > MAX_REQUEST)
+    {
+        return false;
+    }
+
+    ssize_t ret;
+    do {
+        ret = send(fd, buf.data(), buf.size(), MSG_NOSIGNAL);
+    } while ((ret < 0) && (errno == EINTR));
+
+    if (ret != (ssize_t)buf.size())
+    {
+        LOGE("Failed to send a request to the spawn helper: ", strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool wf::spawn_helper_t::receive_reply(uint64_t& id, pid_t& pid)
+{
+    reply_t reply;
+    if (recv(fd, &reply, sizeof(reply), MSG_DONTWAIT) != sizeof(reply))
+    {
+        return false;
+    }
+
+    id  = reply.id;
+    pid = reply.pid;
+    return true;
+}
+
+void wf::spawn_helper_t::dispatch(uint64_t id, pid_t pid)
+{
+    auto it = pending.find(id);
+    if (it == pending.end())
+    {
+        // A spawn_sync() request which timed out.
+        return;
+    }
+
+    auto callback = std::move(it->second);
+    pending.erase(it);
+    if (callback)
+    {
+        callback(pid);
+    }
+}
+
+void wf::spawn_helper_t::dispatch_deferred()
+{
+    auto replies = std::move(deferred);
+    deferred.clear();
+    for (auto& [id, pid] : replies)
+    {
+        dispatch(id, pid);
+    }
+}
+
+bool wf::spawn_helper_t::spawn(const std::string& command, const std::vector<std::string>& env,
+    bool discard_output, callback_t callback)
+{
+    if (!is_running())
+    {
+        return false;
+    }
+
+    uint64_t id = ++last_id;
+    if (!send_request(id, command, env, discard_output))
+    {
+        return false;
+    }
+
+    pending[id] = std::move(callback);
+    return true;
+}
+
+pid_t wf::spawn_helper_t::spawn_sync(const std::string& command,
+    const std::vector<std::string>& env, bool discard_output)
+{
+    if (!is_running())
+    {
+        return -1;
+    }
+
+    uint64_t id = ++last_id;
+    if (!send_request(id, command, env, discard_output))
+    {
+        return -1;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + SYNC_TIMEOUT;
+    while (true)
+    {
+        uint64_t reply_id;
+        pid_t pid;
+        if (receive_reply(reply_id, pid))
+        {
+            if (reply_id == id)
+            {
+                return pid;
+            }
+
+            // Do not run the callbacks of other requests in the middle of the
+            // caller's code.
+            deferred.push_back({reply_id, pid});
+            dispatch_idle.run_once();
+            continue;
+        }
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0)
+        {
+            break;
+        }
+
+        pollfd pfd{fd, POLLIN, 0};
+        int ret = poll(&pfd, 1, left);
+        if ((ret < 0) && (errno != EINTR))
+        {
+            break;
+        }
+
+        if ((pfd.revents & (POLLHUP | POLLERR)) && !(pfd.revents & POLLIN))
+        {
+            break;
+        }
+    }
+
+    LOGE("The spawn helper did not reply for \"", command, "\"");
+    return 0;
+}
+
+int wf::spawn_helper_t::handle_readable(int, uint32_t mask, void *data)
+{
+    auto self = (spawn_helper_t*)data;
+
+    uint64_t id;
+    pid_t pid;
+    while (self->receive_reply(id, pid))
+    {
+        self->dispatch(id, pid);
+    }
+
+    if (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR))
+    {
+        LOGE("The spawn helper exited, starting processes with fork() from now on.");
+        auto lost = std::move(self->pending);
+        self->pending.clear();
+        self->stop();
+        for (auto& [_, callback] : lost)
+        {
+            if (callback)
+            {
+                callback(0);
+            }
+        }
+    }
+
+    return 0;
+}
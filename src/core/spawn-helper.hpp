@@ -0,0 +1,92 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "wayfire/util.hpp"
+
+struct wl_event_loop;
+struct wl_event_source;
+
+namespace wf
+{
+/**
+ * A small process forked at startup, before the compositor has mapped the GPU
+ * and grown its address space, which starts client processes on behalf of
+ * the compositor with posix_spawn().
+ *
+ * Forking the compositor itself copies its page tables, which takes long
+ * enough with a large RSS to delay frames. Requests (the command, the full
+ * environment and whether to discard the output) are sent to the helper over
+ * a SOCK_SEQPACKET socket, and the PIDs of the started processes come back
+ * over the same socket.
+ */
+class spawn_helper_t
+{
+  public:
+    using callback_t = std::function<void (pid_t)>;
+
+    /**
+     * Fork the helper process.
+     *
+     * @param child_setup Called in the helper process before it starts
+     *   serving requests. If it returns false, the helper exits.
+     */
+    spawn_helper_t(std::function<bool()> child_setup);
+    ~spawn_helper_t();
+
+    spawn_helper_t(const spawn_helper_t&) = delete;
+    spawn_helper_t& operator =(const spawn_helper_t&) = delete;
+
+    /** Start receiving the replies of the helper on the given event loop. */
+    void attach(wl_event_loop *loop);
+
+    /** @return Whether the helper is running and accepts requests. */
+    bool is_running() const;
+
+    /**
+     * Start the command with /bin/sh -c.
+     *
+     * @param env The environment of the new process, as KEY=VALUE entries.
+     * @param callback Called from the event loop with the PID of the new
+     *   process, or 0 if it could not be started.
+     *
+     * @return false if the request could not be sent to the helper. The
+     *   callback is not called in this case.
+     */
+    bool spawn(const std::string& command, const std::vector<std::string>& env,
+        bool discard_output, callback_t callback);
+
+    /**
+     * Same as spawn(), but wait for the reply of the helper.
+     *
+     * @return The PID of the new process, 0 if it could not be started, or -1
+     *   if the request could not be sent to the helper.
+     */
+    pid_t spawn_sync(const std::string& command, const std::vector<std::string>& env,
+        bool discard_output);
+
+  private:
+    int fd = -1;
+    pid_t helper_pid = -1;
+    uint64_t last_id = 0;
+    wl_event_source *event_source = nullptr;
+
+    std::map<uint64_t, callback_t> pending;
+
+    /* Replies received while waiting in spawn_sync(), dispatched on idle. */
+    std::vector<std::pair<uint64_t, pid_t>> deferred;
+    wf::wl_idle_call dispatch_idle;
+
+    bool send_request(uint64_t id, const std::string& command,
+        const std::vector<std::string>& env, bool discard_output);
+    bool receive_reply(uint64_t& id, pid_t& pid);
+    void dispatch(uint64_t id, pid_t pid);
+    void dispatch_deferred();
+    void stop();
+
+    static int handle_readable(int fd, uint32_t mask, void *data);
+};
+}
@@ -7,9 +7,16 @@
 #include <wayfire/core.hpp>
 #include <wayfire/util.hpp> // Added for wl_timer
 
+#include <wayfire/config/compound-option.hpp>
+
 #include <cstring>
+#include <sys/eventfd.h>
 #include <sys/inotify.h>
 #include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <thread>
 #include <unistd.h>
 
 #define INOT_BUF_SIZE (sizeof(inotify_event) + NAME_MAX + 1)
@@ -26,9 +33,106 @@ static void add_watch(int fd)
     wd_cfg_file = inotify_add_watch(fd, config_file.c_str(), IN_CLOSE_WRITE);
 }
 
-static void reload_config()
+/**
+ * The raw contents of the config file, section -> option -> value. It is used
+ * to find out which options changed between two versions of the file.
+ */
+struct config_contents_t
+{
+    std::map<std::string, std::map<std::string, std::string>> sections;
+    /* Whether the file uses escapes or line continuations, which are left to
+     * the full parser in wf-config. */
+    bool has_escapes = false;
+};
+
+static std::string trim(const std::string& str)
+{
+    size_t start = str.find_first_not_of(" \t\r");
+    size_t end   = str.find_last_not_of(" \t\r");
+    return (start == std::string::npos) ? "" : str.substr(start, end - start + 1);
+}
+
+/* Safe to call from any thread, does not touch the config manager */
+static config_contents_t read_config_contents(const std::string& file)
+{
+    config_contents_t contents;
+    std::ifstream in(file);
+    std::string line;
+    std::map<std::string, std::string> *section = nullptr;
+    while (std::getline(in, line))
+    {
+        if (line.find('\\') != std::string::npos)
+        {
+            contents.has_escapes = true;
+        }
+
+        line = trim(line.substr(0, line.find('#')));
+        if ((line.size() >= 2) && (line.front() == '[') && (line.back() == ']'))
+        {
+            section = &contents.sections[line.substr(1, line.size() - 2)];
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (section && (eq != std::string::npos))
+        {
+            (*section)[trim(line.substr(0, eq))] = trim(line.substr(eq + 1));
+        }
+    }
+
+    return contents;
+}
+
+/**
+ * Compare two versions of the config file.
+ *
+ * @param changed The changed options, as section/option.
+ * @param removed The options which were removed from the file.
+ */
+static void diff_config_contents(const config_contents_t& old_contents,
+    const config_contents_t& new_contents, std::vector<std::string>& changed,
+    std::vector<std::string>& removed)
 {
-    wf::config::load_configuration_options_from_file(*cfg_manager, config_file);
+    static const std::map<std::string, std::string> empty;
+    auto get_section = [] (const config_contents_t& contents, const std::string& name)
+        -> const std::map<std::string, std::string>&
+    {
+        auto it = contents.sections.find(name);
+        return it == contents.sections.end() ? empty : it->second;
+    };
+
+    std::set<std::string> names;
+    for (auto& [name, _] : old_contents.sections)
+    {
+        names.insert(name);
+    }
+
+    for (auto& [name, _] : new_contents.sections)
+    {
+        names.insert(name);
+    }
+
+    for (auto& name : names)
+    {
+        auto& old_section = get_section(old_contents, name);
+        auto& new_section = get_section(new_contents, name);
+        for (auto& [option, value] : new_section)
+        {
+            auto it = old_section.find(option);
+            if ((it == old_section.end()) || (it->second != value))
+            {
+                changed.push_back(name + "/" + option);
+            }
+        }
+
+        for (auto& [option, _] : old_section)
+        {
+            if (!new_section.count(option))
+            {
+                removed.push_back(name + "/" + option);
+            }
+        }
+    }
 }
 
 static const char *CONFIG_FILE_ENV = "WAYFIRE_CONFIG_FILE";
@@ -43,7 +147,31 @@ class dynamic_ini_config_t : public wf::config_backend_t
     wf::wl_timer<false> reload_timer;
     wf::option_wrapper_t<int> config_reload_delay;
 
+    /* The file contents which the current option values were loaded from */
+    config_contents_t loaded_contents;
+
+    /* The file is read on a separate thread, which signals parse_done_fd */
+    std::thread parse_thread;
+    config_contents_t parsed_contents;
+    int parse_done_fd = -1;
+    struct wl_event_source *parse_done_evtsrc = nullptr;
+    bool reload_again = false;
+
   public:
+    ~dynamic_ini_config_t()
+    {
+        if (parse_thread.joinable())
+        {
+            parse_thread.join();
+        }
+
+        if (parse_done_evtsrc)
+        {
+            wl_event_source_remove(parse_done_evtsrc);
+            close(parse_done_fd);
+        }
+    }
+
     /**
      * Schedules a configuration reload after a delay.
      * If a reload is already scheduled, it will be reset.
@@ -82,6 +210,11 @@ class dynamic_ini_config_t : public wf::config_backend_t
 
             inotify_evtsrc = wl_event_loop_add_fd(wl_display_get_event_loop(display),
                 inotify_fd, WL_EVENT_READABLE, handle_config_updated, this);
+
+            loaded_contents   = read_config_contents(config_file);
+            parse_done_fd     = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            parse_done_evtsrc = wl_event_loop_add_fd(wl_display_get_event_loop(display),
+                parse_done_fd, WL_EVENT_READABLE, handle_config_parsed, this);
         }
     }
 
@@ -137,14 +270,129 @@ class dynamic_ini_config_t : public wf::config_backend_t
     }
 
     /**
-     * Performs the actual configuration reload and emits the signal.
+     * Starts reading the config file in the background.
      * This is called by the wl_timer after the delay.
      */
     void do_reload_config()
     {
+        if (parse_thread.joinable())
+        {
+            // The file changed again while it was being read
+            reload_again = true;
+            return;
+        }
+
         LOGD("Reloading configuration file now!");
-        reload_config();
+        parse_thread = std::thread([this, file = config_file] ()
+        {
+            parsed_contents = read_config_contents(file);
+            uint64_t one    = 1;
+            if (write(parse_done_fd, &one, sizeof(one)) < 0)
+            {
+                LOGE("Failed to notify the main loop of a parsed config file");
+            }
+        });
+    }
+
+    static int handle_config_parsed(int fd, uint32_t mask, void *data)
+    {
+        uint64_t count;
+        if (read(fd, &count, sizeof(count)) < 0)
+        {
+            return 0;
+        }
+
+        auto self = reinterpret_cast<dynamic_ini_config_t*>(data);
+        self->parse_thread.join();
+        self->apply_config_contents(std::move(self->parsed_contents));
+        if (std::exchange(self->reload_again, false))
+        {
+            self->do_reload_config();
+        }
+
+        return 0;
+    }
+
+    /**
+     * Apply the options which changed since the last reload and emit the
+     * reload signal with them. Options are set directly when possible, so that
+     * only the callbacks of changed options run. Anything else, like new
+     * sections or compound options, is handled by reloading the whole file.
+     */
+    void apply_config_contents(config_contents_t contents)
+    {
+        std::vector<std::string> changed, removed;
+        diff_config_contents(loaded_contents, contents, changed, removed);
+        bool full_reload = contents.has_escapes || loaded_contents.has_escapes;
+        loaded_contents = std::move(contents);
+
+        if (changed.empty() && removed.empty() && !full_reload)
+        {
+            LOGD("Configuration file did not change.");
+            check_auto_reload_option();
+            return;
+        }
+
+        std::vector<std::pair<std::shared_ptr<wf::config::option_base_t>, std::string>> to_set;
+        std::vector<std::shared_ptr<wf::config::option_base_t>> to_reset;
+        auto find_simple_option = [&] (const std::string& name)
+        {
+            auto opt = cfg_manager->get_option(name);
+            if (!opt || std::dynamic_pointer_cast<wf::config::compound_option_t>(opt))
+            {
+                full_reload = true;
+                return decltype(opt){};
+            }
+
+            return opt->is_locked() ? decltype(opt){} : opt;
+        };
+
+        for (size_t i = 0; i < changed.size() && !full_reload; i++)
+        {
+            size_t slash = changed[i].find('/');
+            if (auto opt = find_simple_option(changed[i]))
+            {
+                to_set.push_back({opt, loaded_contents.sections.at(changed[i].substr(0, slash))
+                    .at(changed[i].substr(slash + 1))});
+            }
+        }
+
+        for (size_t i = 0; i < removed.size() && !full_reload; i++)
+        {
+            if (auto opt = find_simple_option(removed[i]))
+            {
+                to_reset.push_back(opt);
+            }
+        }
+
+        if (full_reload)
+        {
+            wf::config::load_configuration_options_from_file(*cfg_manager, config_file);
+        } else
+        {
+            for (auto& [opt, value] : to_set)
+            {
+                if (!opt->set_value_str(value))
+                {
+                    LOGW("Invalid value for option ", opt->get_name(), ": ", value);
+                }
+            }
+
+            for (auto& opt : to_reset)
+            {
+                opt->reset_to_default();
+            }
+        }
+
         wf::reload_config_signal ev;
+        ev.changed_options = std::move(changed);
+        ev.changed_options.insert(ev.changed_options.end(), removed.begin(), removed.end());
+        for (auto& name : ev.changed_options)
+        {
+            ev.changed_sections.insert(name.substr(0, name.find('/')));
+        }
+
+        ev.full_reload = full_reload;
         wf::get_core().emit(&ev);
         check_auto_reload_option(); // Re-check auto-reload option after config has been reloaded
     }
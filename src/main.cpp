@@ -43,6 +43,8 @@ static void print_help() {
       << std::endl;
   std::cout << " -R,  --damage-rerender   rerender damaged regions"
             << std::endl;
+  std::cout << " -A,  --alloc-stats       count heap allocations per frame"
+            << std::endl;
   std::cout << " -l,  --legacy-wl-drm     use legacy drm for wayland clients"
             << std::endl;
   std::cout << " -v,  --version           print version and exit" << std::endl;
@@ -263,6 +265,7 @@ int main(int argc, char *argv[]) {
       {"debug", optional_argument, NULL, 'd'},
       {"damage-debug", no_argument, NULL, 'D'},
       {"damage-rerender", no_argument, NULL, 'R'},
+      {"alloc-stats", no_argument, NULL, 'A'},
       {"legacy-wl-drm", no_argument, NULL, 'l'},
       {"with-great-power-comes-great-responsibility", no_argument, NULL, 'r'},
       {"help", no_argument, NULL, 'h'},
@@ -284,7 +287,7 @@ int main(int argc, char *argv[]) {
   }
 
   int c, i;
-  while ((c = getopt_long(argc, argv, "c:B:d::DhRlrv", opts, &i)) != -1) {
+  while ((c = getopt_long(argc, argv, "c:B:d::DhRlrvA", opts, &i)) != -1) {
     switch (c) {
     case 'c':
       config_file = optarg;
@@ -302,6 +305,15 @@ int main(int argc, char *argv[]) {
       runtime_config.no_damage_track = true;
       break;
 
+    case 'A':
+      if (!wf::alloc_stats::enable()) {
+        std::cerr << "Wayfire was built without the alloc_stats option, "
+                     "ignoring --alloc-stats"
+                  << std::endl;
+      }
+
+      break;
+
     case 'l':
       runtime_config.legacy_wl_drm = true;
       break;
@@ -373,6 +385,11 @@ int main(int argc, char *argv[]) {
   });
 
   LOGI("Starting wayfire: ", get_version_string());
+  /* Fork the spawn helper while the compositor is still small, it has to drop
+   * root on its own since it is started before the check below. */
+  auto spawn_helper = std::make_unique<wf::spawn_helper_t>(
+      [=] { return allow_root || drop_permissions(); });
+
   /* First create display and initialize safe-list's event loop, so that
    * wf objects (which depend on safe-list) can work */
   auto display = wl_display_create();
@@ -380,6 +397,7 @@ int main(int argc, char *argv[]) {
 
   core.argc = argc;
   core.argv = argv;
+  core.spawn_helper = std::move(spawn_helper);
 
   /** TODO: move this to core_impl constructor */
   core.display = display;
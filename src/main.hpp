@@ -12,4 +12,21 @@ extern struct wf_runtime_config
 namespace wf
 {
 wf::log::color_mode_t detect_color_mode();
+
+namespace alloc_stats
+{
+/**
+ * Start counting allocations, called once at startup for --alloc-stats.
+ *
+ * @return false if Wayfire was built without the alloc_stats option.
+ */
+bool enable();
+
+/**
+ * Allocations are accounted only between begin_frame() and end_frame(), which
+ * the render manager calls around each output repaint.
+ */
+void begin_frame();
+void end_frame();
+}
 }
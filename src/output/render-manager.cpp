@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <map>
 #include <wayfire/nonstd/reverse.hpp>
 #include <wayfire/nonstd/safe-list.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
@@ -26,23 +27,82 @@
 #include <wlr/types/wlr_gamma_control_v1.h>
 
 namespace wf {
+/**
+ * The shared scratch arena is used by the passes of all outputs. Reset it once
+ * per event loop iteration, after all outputs which repainted in it are done,
+ * so that its trim interval does not depend on the number of outputs.
+ */
+static void schedule_shared_scratch_reset() {
+  static bool reset_pending = false;
+  if (reset_pending) {
+    return;
+  }
+
+  reset_pending = true;
+  wl_event_loop_add_idle(
+      wf::get_core().ev_loop,
+      [](void *) {
+        reset_pending = false;
+        frame_scratch_arena_t::get_shared().reset();
+      },
+      nullptr);
+}
+
+/**
+ * If WAYFIRE_DAMAGE_TRACE is set, the damage of each frame is appended to the
+ * given file before it is simplified, one line per frame:
+ *
+ * <output> <number of rects> <x> <y> <width> <height> ...
+ *
+ * Traces can be replayed with the damage-simplify-bench benchmark.
+ */
+static void record_damage_trace(wf::output_t *output,
+                                const wf::region_t &damage) {
+  static std::ofstream trace = [] {
+    const char *path = getenv("WAYFIRE_DAMAGE_TRACE");
+    return path ? std::ofstream{path, std::ios::app} : std::ofstream{};
+  }();
+
+  if (!trace.is_open()) {
+    return;
+  }
+
+  trace << output->to_string() << " " << damage.rect_count();
+  for (const auto &box : damage) {
+    trace << " " << box.x1 << " " << box.y1 << " " << box.x2 - box.x1 << " "
+          << box.y2 - box.y1;
+  }
+
+  trace << "\n";
+}
+
 /**
  * swapchain_damage_manager_t is responsible for tracking the damage and
  * managing the swapchain on the given output.
  */
 struct swapchain_damage_manager_t {
   wf::option_wrapper_t<bool> force_frame_sync{"workarounds/force_frame_sync"};
+  wf::option_wrapper_t<double> damage_merge_overhead{
+      "core/damage_merge_overhead"};
+  wf::option_wrapper_t<int> damage_max_rects{"core/damage_max_rects"};
+  wf::damage_stats_t damage_stats;
   wf::wl_listener_wrapper on_needs_frame;
   wf::wl_listener_wrapper on_damage;
   wf::wl_listener_wrapper on_gamma_changed;
 
   wf::region_t frame_damage;
+  /* The damage added since the previous frame, without the damage from older
+   * frames which the current swapchain buffer also needs. */
+  wf::region_t latest_damage;
   wlr_output *output;
   wlr_damage_ring damage_ring;
   output_t *wo;
 
   bool pending_gamma_lut = false;
 
+  /* While paused, damage is still tracked but no repaints are scheduled. */
+  bool paused = false;
+
   std::unique_ptr<wf::scene::render_instance_manager_t> instance_manager;
   void start_rendering() {
     scene::damage_callback push_damage = [=](wf::region_t region) {
@@ -281,10 +341,18 @@ struct swapchain_damage_manager_t {
     wlr_damage_ring_rotate_buffer(&damage_ring, next_frame->buffer,
                                   ring_damage.to_pixman());
 
-    frame_damage |= ring_damage;
     if (runtime_config.no_damage_track) {
       frame_damage |= get_buffer_extents();
     }
+
+    latest_damage = frame_damage & get_buffer_extents();
+    frame_damage |= ring_damage;
+
+    record_damage_trace(wo, frame_damage);
+    damage_stats.frames++;
+    damage_stats.rects_before += frame_damage.rect_count();
+    frame_damage.simplify(damage_merge_overhead, damage_max_rects);
+    damage_stats.rects_after += frame_damage.rect_count();
   }
 
   /**
@@ -300,6 +368,10 @@ struct swapchain_damage_manager_t {
    * Schedule a frame for the output
    */
   void schedule_repaint() {
+    if (paused) {
+      return;
+    }
+
     wlr_output_schedule_frame(output);
     force_next_frame = true;
   }
@@ -372,12 +444,202 @@ struct effect_hook_manager_t {
 /**
  * A class to manage and run postprocessing effects
  */
+static const char *pixel_hook_vertex_source = R"(#version 100
+attribute highp vec2 position;
+attribute highp vec2 uvPosition;
+varying highp vec2 uvpos;
+uniform mat4 MVP;
+
+void main() {
+    gl_Position = MVP * vec4(position.xy, 0.0, 1.0);
+    uvpos = uvPosition;
+})";
+
+/**
+ * Fused pixel hook programs, keyed by their fragment shader source. Adding or
+ * removing a hook rebuilds all passes, but only the passes which actually
+ * changed need a new program. Programs which are no longer used are kept for a
+ * while, so that toggling a hook does not compile the same shader again.
+ */
+class post_program_cache_t {
+public:
+  ~post_program_cache_t() {
+    for (auto &[_, entry] : programs) {
+      wf::gles::run_in_context_if_gles(
+          [&] { entry.program->free_resources(); });
+    }
+  }
+
+  /* Get the program for the given fragment source, compiling it if needed */
+  OpenGL::program_t *get(const std::string &fragment_source) {
+    auto &entry = programs[fragment_source];
+    if (!entry.program) {
+      entry.program = std::make_unique<OpenGL::program_t>();
+      entry.program->compile(pixel_hook_vertex_source, fragment_source);
+    }
+
+    entry.last_used = ++generation;
+    return entry.program.get();
+  }
+
+  /* Free the least recently used programs. Must not be called while passes
+   * still refer to programs from the cache. */
+  void trim() {
+    while (programs.size() > MAX_PROGRAMS) {
+      auto oldest = std::min_element(
+          programs.begin(), programs.end(), [](auto &a, auto &b) {
+            return a.second.last_used < b.second.last_used;
+          });
+      wf::gles::run_in_context_if_gles(
+          [&] { oldest->second.program->free_resources(); });
+      programs.erase(oldest);
+    }
+  }
+
+private:
+  static constexpr size_t MAX_PROGRAMS = 8;
+  struct entry_t {
+    std::unique_ptr<OpenGL::program_t> program;
+    uint64_t last_used = 0;
+  };
+
+  std::map<std::string, entry_t> programs;
+  uint64_t generation = 0;
+};
+
+/**
+ * A pass of the postprocessing chain: either a single post hook, or one or
+ * more consecutive pixel hooks fused into a single shader.
+ */
+struct post_pass_t {
+  post_hook_t *hook = nullptr;
+  std::vector<post_pixel_hook_t *> pixel_hooks;
+  /* Owned by the program cache, looked up on the first run of the pass */
+  OpenGL::program_t *program = nullptr;
+
+  std::string fragment_source() const {
+    std::string functions, calls;
+    for (size_t i = 0; i < pixel_hooks.size(); i++) {
+      const std::string name = "_wayfire_pixel_hook" + std::to_string(i);
+      std::string source = pixel_hooks[i]->shader;
+      for (size_t pos = source.find("@name@"); pos != std::string::npos;
+           pos = source.find("@name@", pos + name.length())) {
+        source.replace(pos, std::string("@name@").length(), name);
+      }
+
+      functions += source + "\n";
+      calls += "    color = " + name + "(color);\n";
+    }
+
+    return "#version 100\n@builtin_ext@\n@builtin@\n" + functions +
+           "varying highp vec2 uvpos;\n"
+           "void main() {\n"
+           "    highp vec4 color = get_pixel(uvpos);\n" +
+           calls +
+           "    gl_FragColor = color;\n"
+           "}\n";
+  }
+
+  /* Run the fused pixel hooks on the damaged parts of @source */
+  void run_pixel_hooks(post_program_cache_t &programs,
+                       wf::auxilliary_buffer_t &source,
+                       const wf::render_buffer_t &destination,
+                       const wf::region_t &damage) {
+    if (!wf::get_core().is_gles2()) {
+      for (const auto &box : damage) {
+        auto dst = wlr_box_from_pixman_box(box);
+        destination.blit(source,
+                         {(double)dst.x, (double)dst.y, (double)dst.width,
+                          (double)dst.height},
+                         dst, WLR_SCALE_FILTER_NEAREST);
+      }
+
+      return;
+    }
+
+    wf::gles::run_in_context([&] {
+      if (!program) {
+        program = programs.get(fragment_source());
+      }
+
+      wf::render_target_t target{destination};
+      target.geometry = {0, 0, destination.get_size().width,
+                         destination.get_size().height};
+
+      auto tex = wf::gles_texture_t::from_aux(source);
+      const GLfloat vertex_data[] = {
+          0.0f, (float)target.geometry.height,
+          (float)target.geometry.width, (float)target.geometry.height,
+          (float)target.geometry.width, 0.0f,
+          0.0f, 0.0f,
+      };
+      const GLfloat coord_data[] = {
+          0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+      };
+
+      wf::gles::bind_render_buffer(destination);
+      program->use(tex.type);
+      program->set_active_texture(tex);
+      static const OpenGL::name_id_t position_id{"position"};
+      static const OpenGL::name_id_t uv_position_id{"uvPosition"};
+      static const OpenGL::name_id_t mvp_id{"MVP"};
+      program->attrib_pointer(position_id, 2, 0, vertex_data);
+      program->attrib_pointer(uv_position_id, 2, 0, coord_data);
+      program->uniformMatrix4f(
+          mvp_id, wf::gles::render_target_orthographic_projection(target));
+      for (auto hook : pixel_hooks) {
+        if (hook->set_uniforms) {
+          hook->set_uniforms(*program);
+        }
+      }
+
+      GL_CALL(glDisable(GL_BLEND));
+      for (const auto &box : damage) {
+        wf::gles::render_target_logic_scissor(target,
+                                              wlr_box_from_pixman_box(box));
+        GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+      }
+
+      GL_CALL(glDisable(GL_SCISSOR_TEST));
+      GL_CALL(glEnable(GL_BLEND));
+      program->deactivate();
+    });
+  }
+};
+
 struct postprocessing_manager_t {
-  using post_container_t = wf::safe_list_t<post_hook_t *>;
+  /* Either hook or pixel_hook is set */
+  struct post_effect_t {
+    post_hook_t *hook = nullptr;
+    post_pixel_hook_t *pixel_hook = nullptr;
+
+    bool operator==(const post_effect_t &other) const {
+      return (hook == other.hook) && (pixel_hook == other.pixel_hook);
+    }
+  };
+
+  using post_container_t = wf::safe_list_t<post_effect_t>;
   post_container_t post_effects;
-  wf::auxilliary_buffer_t post_buffers[2];
+
   /* Buffer to which other operations render to */
-  static constexpr uint32_t default_out_buffer = 0;
+  wf::auxilliary_buffer_t scene_buffer;
+
+  /**
+   * Each pass except the last one renders to its own intermediate buffer,
+   * which is kept across frames. Since the input of a pass only changes where
+   * the output was damaged, the pass only needs to process the new damage,
+   * plus the parts of its buffer which are stale, for example because it was
+   * just allocated or because the passes have changed.
+   */
+  struct intermediate_buffer_t {
+    wf::auxilliary_buffer_t buffer;
+    wf::region_t stale;
+  };
+
+  std::vector<post_pass_t> passes;
+  std::vector<intermediate_buffer_t> intermediate;
+  bool passes_dirty = true;
+  post_program_cache_t programs;
 
   output_t *output;
   uint32_t output_width, output_height;
@@ -397,47 +659,104 @@ struct postprocessing_manager_t {
 
     output_width = width;
     output_height = height;
-    for (auto &buffer : post_buffers) {
-      buffer.allocate({width, height});
+    scene_buffer.allocate({width, height});
+    if (passes_dirty) {
+      rebuild_passes();
+    }
+
+    for (auto &buffer : intermediate) {
+      if (buffer.buffer.allocate({width, height}) ==
+          buffer_reallocation_result_t::REALLOCATED) {
+        buffer.stale |= wlr_box{0, 0, width, height};
+      }
     }
   }
 
-  void add_post(post_hook_t *hook) {
-    post_effects.push_back(hook);
+  void add_post(post_effect_t effect) {
+    post_effects.push_back(effect);
+    passes_dirty = true;
     output->render->damage_whole_idle();
   }
 
-  void rem_post(post_hook_t *hook) {
-    post_effects.remove_all(hook);
+  void rem_post(post_effect_t effect) {
+    post_effects.remove_all(effect);
+    passes_dirty = true;
     output->render->damage_whole_idle();
   }
 
-  /* Run all postprocessing effects, rendering to alternating buffers and
-   * finally to the screen.
-   *
-   * NB: 2 buffers just aren't enough. We render to the zero buffer, and then
-   * we alternately render to the second and the third. The reason: We track
-   * damage. So, we need to keep the whole buffer each frame. */
-  void run_post_effects(const wf::region_t &damage = {}) {
-    int cur_idx = 0;
-    post_effects.for_each([&](auto post) -> void {
-      int next_idx = 1 - cur_idx;
-      wf::render_buffer_t dst_buffer =
-          (post == post_effects.back()
-               ? final_target
-               : post_buffers[next_idx].get_renderbuffer());
-
-      // Pass damage to the effect operator if supported by the plugin
-      (*post)(post_buffers[cur_idx], dst_buffer, damage);
-      cur_idx = next_idx;
+  /* Group consecutive pixel hooks into passes */
+  void rebuild_passes() {
+    passes.clear();
+    post_effects.for_each([&](const post_effect_t &effect) {
+      if (effect.pixel_hook && !passes.empty() &&
+          !passes.back().pixel_hooks.empty()) {
+        passes.back().pixel_hooks.push_back(effect.pixel_hook);
+        return;
+      }
+
+      post_pass_t pass;
+      pass.hook = effect.hook;
+      if (effect.pixel_hook) {
+        pass.pixel_hooks.push_back(effect.pixel_hook);
+      }
+
+      passes.push_back(std::move(pass));
     });
+
+    programs.trim();
+
+    intermediate.resize(passes.empty() ? 0 : passes.size() - 1);
+    for (auto &buffer : intermediate) {
+      buffer.stale = wlr_box{0, 0, (int)output_width, (int)output_height};
+    }
+
+    passes_dirty = false;
+  }
+
+  /**
+   * Run all postprocessing effects, each pass rendering to its own buffer and
+   * the last one to the screen.
+   *
+   * @param latest_damage The damage since the previous frame, which has to be
+   *   processed again by the intermediate passes.
+   * @param swap_damage The damage of the swapchain buffer, which the last pass
+   *   has to repaint.
+   */
+  void run_post_effects(const wf::region_t &latest_damage,
+                        const wf::region_t &swap_damage) {
+    wf::region_t damage = latest_damage;
+    wf::auxilliary_buffer_t *source = &scene_buffer;
+    for (size_t i = 0; i < passes.size(); i++) {
+      const bool last = (i + 1 == passes.size());
+      wf::render_buffer_t destination =
+          last ? final_target : intermediate[i].buffer.get_renderbuffer();
+      if (last) {
+        damage |= swap_damage;
+      } else {
+        damage |= intermediate[i].stale;
+        intermediate[i].stale.clear();
+      }
+
+      if (passes[i].hook) {
+        // Post hooks may keep state of their own based on the damage they
+        // get, so they always get at least the damage of the swapchain
+        // buffer, as when every hook rendered to it.
+        damage |= swap_damage;
+        (*passes[i].hook)(*source, destination, damage);
+      } else {
+        passes[i].run_pixel_hooks(programs, *source, destination, damage);
+      }
+
+      if (!last) {
+        source = &intermediate[i].buffer;
+      }
+    }
   }
 
   wf::render_target_t get_target_framebuffer() const {
-    wf::render_target_t fb{
-        post_effects.size() > 0
-            ? post_buffers[default_out_buffer].get_renderbuffer()
-            : final_target};
+    wf::render_target_t fb{post_effects.size() > 0
+                               ? scene_buffer.get_renderbuffer()
+                               : final_target};
 
     fb.geometry = output->get_relative_geometry();
     fb.wl_transform = output->handle->transform;
@@ -706,6 +1025,7 @@ public:
 
   wf::option_wrapper_t<wf::color_t> background_color_opt;
   std::unique_ptr<wf::render_pass_t> current_pass;
+  wf::frame_scratch_arena_t frame_scratch;
   wf::option_wrapper_t<std::string> icc_profile;
 
   wlr_color_transform *get_color_transform() { return icc_color_transform; }
@@ -740,8 +1060,11 @@ public:
         });
       }
 
-      frame_done_signal ev;
-      output->emit(&ev);
+      /* Inhibited outputs send frame done events on a timer instead */
+      if (!damage_manager->paused) {
+        frame_done_signal ev;
+        output->emit(&ev);
+      }
     });
 
     on_frame.connect(&output->handle->events.frame);
@@ -822,9 +1145,22 @@ public:
   }
 
   int output_inhibit_counter = 0;
+
+  /* While the output is inhibited, surfaces get frame done events at this
+   * interval (in milliseconds) instead of on each frame. */
+  static constexpr uint32_t INHIBITED_FRAME_DONE_INTERVAL = 1000;
+  wf::wl_timer<true> inhibited_frame_done;
+
   void add_inhibit(bool add) {
     output_inhibit_counter += add ? 1 : -1;
+    if (add && (output_inhibit_counter == 1)) {
+      // Show the black frame
+      damage_manager->schedule_repaint();
+    }
+
     if (output_inhibit_counter == 0) {
+      damage_manager->paused = false;
+      inhibited_frame_done.disconnect();
       damage_manager->damage_whole_idle();
 
       wf::output_start_rendering_signal data;
@@ -936,9 +1272,20 @@ public:
    * Repaints the whole output, includes all effects and hooks
    */
   void paint() {
+    wf::alloc_stats::begin_frame();
+    paint_frame();
+    wf::alloc_stats::end_frame();
+  }
+
+  void paint_frame() {
     effects->run_effects(OUTPUT_EFFECT_PRE);
     effects->run_effects(OUTPUT_EFFECT_DAMAGE);
 
+    if (output_inhibit_counter) {
+      paint_inhibited();
+      return;
+    }
+
     if (do_direct_scanout()) {
       return;
     }
@@ -954,26 +1301,67 @@ public:
 
     effects->run_effects(OUTPUT_EFFECT_OVERLAY);
 
-    if (output_inhibit_counter) {
-      current_pass->clear(current_pass->get_target().geometry, {0, 0, 0, 1});
-    }
-
     current_pass->submit();
     current_pass.reset();
 
     effects->run_effects(OUTPUT_EFFECT_PASS_DONE);
 
     if (postprocessing->post_effects.size()) {
-      postprocessing->run_post_effects(swap_damage);
+      postprocessing->run_post_effects(damage_manager->latest_damage,
+                                       swap_damage);
     }
 
     damage_manager->swap_buffers(std::move(next_frame), swap_damage);
+    frame_scratch.reset();
+    schedule_shared_scratch_reset();
 
     unset_bound_output();
     swap_damage.clear();
     post_paint();
   }
 
+  /**
+   * Paint a single black frame on an inhibited output without rendering the
+   * scene. Afterwards, the output stops scheduling repaints until it is
+   * uninhibited.
+   */
+  void paint_inhibited() {
+    if (damage_manager->paused) {
+      return;
+    }
+
+    damage_manager->force_next_frame = true;
+    auto next_frame = damage_manager->start_frame();
+    if (!next_frame) {
+      return;
+    }
+
+    auto pass = wlr_renderer_begin_buffer_pass(output->handle->renderer,
+                                               next_frame->buffer, nullptr);
+    if (!pass) {
+      LOGE("Failed to clear inhibited output!");
+      wlr_buffer_unlock(next_frame->buffer);
+      return;
+    }
+
+    wlr_render_rect_options black{};
+    black.box = damage_manager->get_buffer_extents();
+    black.color = {0, 0, 0, 1};
+    black.blend_mode = WLR_RENDER_BLEND_MODE_NONE;
+    wlr_render_pass_add_rect(pass, &black);
+    wlr_render_pass_submit(pass);
+
+    damage_manager->swap_buffers(std::move(next_frame), black.box);
+    damage_manager->paused = true;
+    inhibited_frame_done.set_timeout(INHIBITED_FRAME_DONE_INTERVAL, [=]() {
+      frame_done_signal ev;
+      output->emit(&ev);
+      return true;
+    });
+
+    post_paint();
+  }
+
   void
   render_sw_cursors(swapchain_damage_manager_t::frame_object_t *next_frame) {
     auto sw_cursor_pass = wlr_renderer_begin_buffer_pass(
@@ -1040,6 +1428,10 @@ void render_manager::schedule_redraw() {
 
 void render_manager::add_inhibit(bool add) { pimpl->add_inhibit(add); }
 
+bool render_manager::is_inhibited() const {
+  return pimpl->output_inhibit_counter > 0;
+}
+
 void render_manager::add_effect(effect_hook_t *hook,
                                 output_effect_type_t type) {
   pimpl->effects->add_effect(hook, type);
@@ -1050,11 +1442,19 @@ void render_manager::rem_effect(effect_hook_t *hook) {
 }
 
 void render_manager::add_post(post_hook_t *hook) {
-  pimpl->postprocessing->add_post(hook);
+  pimpl->postprocessing->add_post({hook, nullptr});
 }
 
 void render_manager::rem_post(post_hook_t *hook) {
-  pimpl->postprocessing->rem_post(hook);
+  pimpl->postprocessing->rem_post({hook, nullptr});
+}
+
+void render_manager::add_post(post_pixel_hook_t *hook) {
+  pimpl->postprocessing->add_post({nullptr, hook});
+}
+
+void render_manager::rem_post(post_pixel_hook_t *hook) {
+  pimpl->postprocessing->rem_post({nullptr, hook});
 }
 
 wf::region_t render_manager::get_scheduled_damage() {
@@ -1095,6 +1495,14 @@ void render_manager::set_require_depth_buffer(bool require) {
   return pimpl->depth_buffer_manager->set_required(require);
 }
 
+wf::damage_stats_t render_manager::get_damage_stats() const {
+  return pimpl->damage_manager->damage_stats;
+}
+
+wf::frame_scratch_arena_t &render_manager::get_frame_scratch() {
+  return pimpl->frame_scratch;
+}
+
 wf::render_pass_t *render_manager::get_current_pass() {
   return pimpl->current_pass.get();
 }
@@ -183,7 +183,17 @@ class workspace_set_root_node_t : public wf::scene::floating_inner_node_t
 
 std::vector<nonstd::observer_ptr<workspace_set_t>> workspace_set_t::get_all()
 {
-    return tracking_allocator_t<workspace_set_t>::get().get_all();
+    // The list may contain freed workspace sets if this is called from a for_each().
+    std::vector<nonstd::observer_ptr<workspace_set_t>> wsets;
+    for (auto& wset : tracking_allocator_t<workspace_set_t>::get().get_all())
+    {
+        if (wset)
+        {
+            wsets.push_back(wset);
+        }
+    }
+
+    return wsets;
 }
 
 struct workspace_set_t::impl
@@ -1,5 +1,7 @@
 #include <wayfire/region.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
+#include <algorithm>
+#include <vector>
 
 /* Pixman helpers */
 wlr_box wlr_box_from_pixman_box(const pixman_box32_t& box)
@@ -35,6 +37,11 @@ wf::region_t::region_t(const wlr_box& box)
     pixman_region32_init_rect(&_region, box.x, box.y, box.width, box.height);
 }
 
+wf::region_t::region_t(const pixman_box32_t *boxes, int count)
+{
+    pixman_region32_init_rects(&_region, boxes, count);
+}
+
 wf::region_t::~region_t()
 {
     pixman_region32_fini(&_region);
@@ -123,6 +130,141 @@ void wf::region_t::expand_edges(int amount)
     free(dst_rects);
 }
 
+static int64_t box_area(const pixman_box32_t& box)
+{
+    return int64_t(box.x2 - box.x1) * (box.y2 - box.y1);
+}
+
+static pixman_box32_t bounding_box(const pixman_box32_t& a, const pixman_box32_t& b)
+{
+    return {
+        std::min(a.x1, b.x1), std::min(a.y1, b.y1),
+        std::max(a.x2, b.x2), std::max(a.y2, b.y2),
+    };
+}
+
+static int64_t overlap_area(const pixman_box32_t& a, const pixman_box32_t& b)
+{
+    int64_t width  = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+    int64_t height = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+    return std::max<int64_t>(0, width) * std::max<int64_t>(0, height);
+}
+
+/* The area which merging two boxes adds to their union. Merged boxes may
+ * already overlap the next ones, so the overlap must not be counted twice. */
+static int64_t merge_cost(const pixman_box32_t& a, const pixman_box32_t& b)
+{
+    return box_area(bounding_box(a, b)) - box_area(a) - box_area(b) + overlap_area(a, b);
+}
+
+/* Merge the cheapest pairs of neighbouring boxes until at most max_boxes remain */
+static void merge_boxes_to_count(std::vector<pixman_box32_t>& boxes, size_t max_boxes)
+{
+    while (boxes.size() > std::max<size_t>(1, max_boxes))
+    {
+        size_t best = 0;
+        int64_t best_cost = merge_cost(boxes[0], boxes[1]);
+        for (size_t i = 1; i + 1 < boxes.size(); i++)
+        {
+            int64_t cost = merge_cost(boxes[i], boxes[i + 1]);
+            if (cost < best_cost)
+            {
+                best = i;
+                best_cost = cost;
+            }
+        }
+
+        boxes[best] = bounding_box(boxes[best], boxes[best + 1]);
+        boxes.erase(boxes.begin() + best + 1);
+    }
+}
+
+void wf::region_t::simplify(double max_overhead, int max_rects)
+{
+    int nrects;
+    const pixman_box32_t *rects = pixman_region32_rectangles(&_region, &nrects);
+    const bool over_cap = (max_rects > 0) && (nrects > max_rects);
+    if ((nrects <= 1) || ((max_overhead <= 0) && !over_cap))
+    {
+        return;
+    }
+
+    /* Merge candidates are searched among the last few boxes, which are the
+     * closest ones because pixman sorts rectangles by y, then by x. */
+    const int LOOKBACK = 8;
+
+    int64_t area = 0;
+    for (int i = 0; i < nrects; i++)
+    {
+        area += box_area(rects[i]);
+    }
+
+    int64_t budget = int64_t(area * std::max(0.0, max_overhead));
+    std::vector<pixman_box32_t> boxes;
+    boxes.reserve(nrects);
+    for (int i = 0; i < nrects; i++)
+    {
+        int best = -1;
+        int64_t best_cost = 0;
+        for (int j = (int)boxes.size() - 1; j >= std::max(0, (int)boxes.size() - LOOKBACK); j--)
+        {
+            int64_t cost = merge_cost(boxes[j], rects[i]);
+            if ((cost <= budget) && ((best < 0) || (cost < best_cost)))
+            {
+                best = j;
+                best_cost = cost;
+            }
+        }
+
+        if (best >= 0)
+        {
+            boxes[best] = bounding_box(boxes[best], rects[i]);
+            budget -= best_cost;
+        } else
+        {
+            boxes.push_back(rects[i]);
+        }
+    }
+
+    /* Boxes merged across bands can split the bands of their neighbours, keep
+     * the original region if the merge did not reduce the number of rects. */
+    std::vector<pixman_box32_t> original(rects, rects + nrects);
+    pixman_region32_fini(&_region);
+    pixman_region32_init_rects(&_region, boxes.data(), boxes.size());
+    if (pixman_region32_n_rects(&_region) > nrects)
+    {
+        pixman_region32_fini(&_region);
+        pixman_region32_init_rects(&_region, original.data(), original.size());
+    }
+
+    if (max_rects <= 0)
+    {
+        return;
+    }
+
+    /* Overlapping boxes are split into bands by pixman, so the region may end
+     * up with more rectangles than boxes. Merge more aggressively until the cap
+     * holds, falling back to the extents of the region. */
+    for (size_t target = max_rects; target >= 1; target /= 2)
+    {
+        rects = pixman_region32_rectangles(&_region, &nrects);
+        if (nrects <= max_rects)
+        {
+            return;
+        }
+
+        boxes.assign(rects, rects + nrects);
+        merge_boxes_to_count(boxes, target);
+        pixman_region32_fini(&_region);
+        pixman_region32_init_rects(&_region, boxes.data(), boxes.size());
+    }
+}
+
+int wf::region_t::rect_count() const
+{
+    return pixman_region32_n_rects(this->unconst());
+}
+
 pixman_box32_t wf::region_t::get_extents() const
 {
     return *pixman_region32_extents(this->unconst());
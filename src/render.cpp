@@ -2,7 +2,10 @@
 #include "wayfire/dassert.hpp"
 #include "wayfire/nonstd/reverse.hpp"
 #include "wayfire/opengl.hpp"
+#include "wayfire/output.hpp"
+#include "wayfire/render-manager.hpp"
 #include <drm_fourcc.h>
+#include <list>
 #include <wayfire/render.hpp>
 #include <wayfire/scene-render.hpp>
 
@@ -22,8 +25,10 @@ wf::auxilliary_buffer_t::operator=(auxilliary_buffer_t &&other) {
     return *this;
   }
 
+  free();
   this->texture = std::exchange(other.texture, nullptr);
   this->buffer = std::exchange(other.buffer, {});
+  this->format = std::exchange(other.format, 0);
   return *this;
 }
 
@@ -81,13 +86,12 @@ wf::auxilliary_buffer_t::allocate(wf::dimensions_t size, float scale,
     return buffer_reallocation_result_t::FAILED;
   }
 
-  buffer.buffer = wlr_allocator_create_buffer(wf::get_core_impl().allocator,
-                                              size.width, size.height, format);
+  auto &pool = buffer_pool_t::get();
+  buffer.buffer = pool.acquire(size, format);
 
   if (!buffer.buffer) {
     size = sanitize_buffer_size(size, FALLBACK_MAX_BUFFER_SIZE);
-    buffer.buffer = wlr_allocator_create_buffer(
-        wf::get_core_impl().allocator, size.width, size.height, format);
+    buffer.buffer = pool.acquire(size, format);
   }
 
   if (!buffer.buffer) {
@@ -95,6 +99,7 @@ wf::auxilliary_buffer_t::allocate(wf::dimensions_t size, float scale,
   }
 
   buffer.size = size;
+  this->format = format->format;
   return buffer_reallocation_result_t::REALLOCATED;
 }
 
@@ -106,13 +111,122 @@ void wf::auxilliary_buffer_t::free() {
   texture = NULL;
 
   if (buffer.get_buffer()) {
-    wlr_buffer_drop(buffer.get_buffer());
+    buffer_pool_t::get().release(buffer.get_buffer(), format);
   }
 
   buffer.buffer = NULL;
   buffer.size = {0, 0};
 }
 
+struct wf::buffer_pool_t::impl {
+  struct entry_t {
+    wlr_buffer *buffer;
+    uint32_t format;
+    // The modifier of dmabuf buffers. Other buffers (e.g. shm) do not have a
+    // modifier and can be used for any request.
+    std::optional<uint64_t> modifier;
+    size_t bytes;
+  };
+
+  // Free buffers, the most recently released first.
+  std::list<entry_t> free_buffers;
+  stats_t stats;
+
+  static std::optional<uint64_t> buffer_modifier(wlr_buffer *buffer) {
+    wlr_dmabuf_attributes dmabuf;
+    if (wlr_buffer_get_dmabuf(buffer, &dmabuf)) {
+      return dmabuf.modifier;
+    }
+
+    return {};
+  }
+
+  static bool modifier_allowed(const entry_t &entry,
+                               const wlr_drm_format *format) {
+    return !entry.modifier || wlr_drm_format_has(format, *entry.modifier);
+  }
+
+  static size_t buffer_bytes(wlr_buffer *buffer) {
+    // All formats used for auxilliary buffers have 4 bytes per pixel.
+    return size_t(buffer->width) * buffer->height * 4;
+  }
+
+  void destroy_oldest() {
+    auto &entry = free_buffers.back();
+    stats.bytes -= entry.bytes;
+    wlr_buffer_drop(entry.buffer);
+    free_buffers.pop_back();
+  }
+
+  void trim(size_t max_bytes) {
+    while (!free_buffers.empty() && (stats.bytes > max_bytes)) {
+      destroy_oldest();
+      ++stats.evictions;
+    }
+
+    stats.buffers = free_buffers.size();
+  }
+};
+
+wf::buffer_pool_t::buffer_pool_t() : priv(std::make_unique<impl>()) {}
+wf::buffer_pool_t::~buffer_pool_t() = default;
+
+wlr_buffer *wf::buffer_pool_t::acquire(wf::dimensions_t size,
+                                       const wlr_drm_format *format) {
+  for (auto it = priv->free_buffers.begin(); it != priv->free_buffers.end();
+       ++it) {
+    if ((it->buffer->width == size.width) &&
+        (it->buffer->height == size.height) &&
+        (it->format == format->format) &&
+        impl::modifier_allowed(*it, format)) {
+      auto buffer = it->buffer;
+      priv->stats.bytes -= it->bytes;
+      priv->free_buffers.erase(it);
+      priv->stats.buffers = priv->free_buffers.size();
+      ++priv->stats.hits;
+      return buffer;
+    }
+  }
+
+  ++priv->stats.misses;
+  return wlr_allocator_create_buffer(wf::get_core_impl().allocator, size.width,
+                                     size.height, format);
+}
+
+void wf::buffer_pool_t::release(wlr_buffer *buffer, uint32_t format) {
+  static wf::option_wrapper_t<int> pool_size{"core/buffer_pool_size"};
+  const size_t max_bytes = size_t(std::max(0, (int)pool_size)) << 20;
+
+  auto bytes = impl::buffer_bytes(buffer);
+  if ((bytes > max_bytes) || (wf::get_core().get_current_state() ==
+                              wf::compositor_state_t::SHUTDOWN)) {
+    wlr_buffer_drop(buffer);
+    return;
+  }
+
+  priv->free_buffers.push_front(
+      {buffer, format, impl::buffer_modifier(buffer), bytes});
+  priv->stats.bytes += bytes;
+  priv->trim(max_bytes);
+}
+
+void wf::buffer_pool_t::clear() {
+  while (!priv->free_buffers.empty()) {
+    priv->destroy_oldest();
+  }
+
+  priv->stats.buffers = 0;
+}
+
+wf::buffer_pool_t::stats_t wf::buffer_pool_t::get_stats() const {
+  return priv->stats;
+}
+
+wf::buffer_pool_t &wf::buffer_pool_t::get() {
+  static buffer_pool_t pool;
+  return pool;
+}
+
 wlr_buffer *wf::auxilliary_buffer_t::get_buffer() const {
   return buffer.get_buffer();
 }
@@ -227,14 +341,87 @@ wf::render_target_t::framebuffer_box_from_geometry_box(wlr_box box) const {
   return round_fbox_to_containing_box(scaled_fbox);
 }
 
+namespace {
+/**
+ * The mapping between geometry and framebuffer coordinates of a render target
+ * is always an affine map which keeps boxes axis-aligned:
+ *
+ * p' = origin + p.x * dx + p.y * dy
+ *
+ * where dx and dy are parallel to the coordinate axes.
+ */
+struct point_mapping_t {
+  wf::pointf_t origin;
+  wf::pointf_t dx;
+  wf::pointf_t dy;
+};
+
+/**
+ * Find the mapping implemented by a box transformation function by transforming
+ * three empty boxes (i.e points).
+ */
+template <class BoxMapping>
+point_mapping_t sample_point_mapping(BoxMapping &&map_box) {
+  auto map_point = [&](double x, double y) {
+    wlr_fbox mapped = map_box(wlr_fbox{x, y, 0, 0});
+    return wf::pointf_t{mapped.x, mapped.y};
+  };
+
+  auto origin = map_point(0, 0);
+  auto x_axis = map_point(1, 0);
+  auto y_axis = map_point(0, 1);
+  return {
+      origin,
+      {x_axis.x - origin.x, x_axis.y - origin.y},
+      {y_axis.x - origin.x, y_axis.y - origin.y},
+  };
+}
+
+/* Transformed coordinates closer than this to an integer are treated as that
+ * integer, so that rounding errors do not grow boxes by a whole pixel. */
+static constexpr double SNAP_EPSILON = 1e-6;
+
+/**
+ * Transform all boxes of the region and round them outwards to integer
+ * coordinates, then build the result with a single pixman call, instead of
+ * one union per box.
+ */
+wf::region_t transform_region(const wf::region_t &region,
+                              const point_mapping_t &m) {
+  int nr_boxes = 0;
+  const pixman_box32_t *src = pixman_region32_rectangles(
+      const_cast<pixman_region32_t *>(region.to_pixman()), &nr_boxes);
+
+  // Reused between calls, so that transforming damage does not allocate
+  // in the steady state.
+  static std::vector<pixman_box32_t> dst;
+  dst.resize(nr_boxes);
+
+  for (int i = 0; i < nr_boxes; i++) {
+    double ax = m.origin.x + src[i].x1 * m.dx.x + src[i].y1 * m.dy.x;
+    double ay = m.origin.y + src[i].x1 * m.dx.y + src[i].y1 * m.dy.y;
+    double bx = m.origin.x + src[i].x2 * m.dx.x + src[i].y2 * m.dy.x;
+    double by = m.origin.y + src[i].x2 * m.dx.y + src[i].y2 * m.dy.y;
+
+    dst[i].x1 = std::floor(std::min(ax, bx) + SNAP_EPSILON);
+    dst[i].y1 = std::floor(std::min(ay, by) + SNAP_EPSILON);
+    dst[i].x2 = std::ceil(std::max(ax, bx) - SNAP_EPSILON);
+    dst[i].y2 = std::ceil(std::max(ay, by) - SNAP_EPSILON);
+  }
+
+  return wf::region_t{dst.data(), nr_boxes};
+}
+} // namespace
+
 wf::region_t wf::render_target_t::framebuffer_region_from_geometry_region(
     const wf::region_t &region) const {
-  wf::region_t result;
-  for (const auto &rect : region) {
-    result |= framebuffer_box_from_geometry_box(wlr_box_from_pixman_box(rect));
+  if (region.empty()) {
+    return {};
   }
 
-  return result;
+  auto mapping = sample_point_mapping(
+      [&](wlr_fbox box) { return framebuffer_box_from_geometry_box(box); });
+  return transform_region(region, mapping);
 }
 
 wlr_fbox
@@ -270,12 +457,67 @@ wf::render_target_t::geometry_box_from_framebuffer_box(wlr_box fb_box) const {
 
 wf::region_t wf::render_target_t::geometry_region_from_framebuffer_region(
     const wf::region_t &region) const {
-  wf::region_t result;
-  for (const auto &rect : region) {
-    result |= geometry_box_from_framebuffer_box(wlr_box_from_pixman_box(rect));
+  if (region.empty()) {
+    return {};
   }
 
-  return result;
+  auto mapping = sample_point_mapping(
+      [&](wlr_fbox box) { return geometry_fbox_from_framebuffer_box(box); });
+  return transform_region(region, mapping);
+}
+
+/* Number of frames over which the arena's peak usage is measured before unused
+ * lists and excess capacity are released. */
+static constexpr int SCRATCH_TRIM_INTERVAL = 120;
+
+wf::frame_scratch_arena_t::frame_scratch_arena_t() = default;
+wf::frame_scratch_arena_t::~frame_scratch_arena_t() = default;
+
+wf::frame_scratch_arena_t::instruction_list_t *
+wf::frame_scratch_arena_t::acquire_instructions() {
+  ++in_use;
+  peak_in_use = std::max(peak_in_use, in_use);
+  if (free_lists.empty()) {
+    return new instruction_list_t();
+  }
+
+  auto list = free_lists.back().release();
+  free_lists.pop_back();
+  return list;
+}
+
+void wf::frame_scratch_arena_t::release_instructions(instruction_list_t *list) {
+  --in_use;
+  peak_list_size = std::max(peak_list_size, list->size());
+  list->clear();
+  free_lists.emplace_back(list);
+}
+
+void wf::frame_scratch_arena_t::reset() {
+  if (++frames_since_trim < SCRATCH_TRIM_INTERVAL) {
+    return;
+  }
+
+  if (free_lists.size() > peak_in_use) {
+    free_lists.resize(peak_in_use);
+  }
+
+  for (auto &list : free_lists) {
+    if (list->capacity() > 2 * peak_list_size) {
+      instruction_list_t trimmed;
+      trimmed.reserve(peak_list_size);
+      list->swap(trimmed);
+    }
+  }
+
+  frames_since_trim = 0;
+  peak_in_use = in_use;
+  peak_list_size = 0;
+}
+
+wf::frame_scratch_arena_t &wf::frame_scratch_arena_t::get_shared() {
+  static frame_scratch_arena_t shared;
+  return shared;
 }
 
 wf::render_pass_t::render_pass_t(const render_pass_params_t &p) {
@@ -301,11 +543,17 @@ wf::region_t wf::render_pass_t::run_partial() {
 
   wf::region_t swap_damage = accumulated_damage;
 
-  std::vector<wf::scene::render_instruction_t> instructions;
+  frame_scratch_arena_t *scratch = params.scratch;
+  if (!scratch) {
+    scratch = params.reference_output
+                  ? &params.reference_output->render->get_frame_scratch()
+                  : &frame_scratch_arena_t::get_shared();
+  }
 
+  auto instructions = scratch->acquire_instructions();
   if (params.instances) {
     for (auto &inst : *params.instances) {
-      inst->schedule_instructions(instructions, params.target,
+      inst->schedule_instructions(*instructions, params.target,
                                   accumulated_damage);
     }
   }
@@ -315,6 +563,7 @@ wf::region_t wf::render_pass_t::run_partial() {
       params.pass_opts);
 
   if (!pass) {
+    scratch->release_instructions(instructions);
     return accumulated_damage;
   }
 
@@ -322,11 +571,12 @@ wf::region_t wf::render_pass_t::run_partial() {
     clear(accumulated_damage, params.background_color);
   }
 
-  for (auto &instr : wf::reverse(instructions)) {
+  for (auto &instr : wf::reverse(*instructions)) {
     instr.pass = this;
     instr.instance->render(instr);
   }
 
+  scratch->release_instructions(instructions);
   return swap_damage;
 }
 
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
+#include <optional>
 
 #include <wayfire/seat.hpp>
 #include <wayfire/workarea.hpp>
@@ -50,6 +51,9 @@ class wayfire_layer_shell_view : public wf::view_interface_t
     /** The output geometry of the view */
     wf::geometry_t geometry{100, 100, 0, 0};
 
+    /** The box sent with the last configure, used to skip redundant configures */
+    std::optional<wf::geometry_t> last_configured;
+
     std::string app_id;
     friend class wf::tracking_allocator_t<view_interface_t>;
     wayfire_layer_shell_view(wlr_layer_surface_v1 *lsurf);
@@ -360,6 +364,37 @@ struct wf_layer_shell_manager
         view->get_output()->workarea->reflow_reserved_areas();
     }
 
+    /**
+     * Rearrange the views after the reserved area of a view in @layer may have
+     * changed. Floating views in the other layers are moved only if the
+     * workarea actually changed.
+     */
+    void arrange_layer(wf::output_t *output, uint32_t layer)
+    {
+        auto old_workarea = output->workarea->get_workarea();
+        arrange_exclusive_zone(output, layer);
+        output->workarea->reflow_reserved_areas();
+
+        if (output->workarea->get_workarea() == old_workarea)
+        {
+            arrange_floating(output, layer);
+        } else
+        {
+            for (int i = 0; i < COUNT_LAYERS; i++)
+            {
+                arrange_floating(output, i);
+            }
+        }
+    }
+
+    /**
+     * Move a view without reserved area, which does not affect other views.
+     */
+    void arrange_floating_view(wayfire_layer_shell_view *view)
+    {
+        pin_view(view, view->get_output()->workarea->get_workarea());
+    }
+
     void arrange_layers(wf::output_t *output)
     {
         const auto layers = {
@@ -529,9 +564,24 @@ void wayfire_layer_shell_view::unmap()
     on_surface_commit.disconnect();
     emit_view_unmap();
     priv->set_enabled(false);
+    last_configured.reset();
     wf_layer_shell_manager::get_instance().handle_unmap(this);
 }
 
+/**
+ * Whether the committed state changed in a way which affects the position or
+ * the reserved area of the layer surface. Clients like status bars often
+ * commit the same state again, which does not require any rearrangement.
+ */
+static bool placement_changed(const wlr_layer_surface_v1_state& a,
+    const wlr_layer_surface_v1_state& b)
+{
+    return (a.anchor != b.anchor) || (a.exclusive_zone != b.exclusive_zone) ||
+           (a.margin.top != b.margin.top) || (a.margin.right != b.margin.right) ||
+           (a.margin.bottom != b.margin.bottom) || (a.margin.left != b.margin.left) ||
+           (a.desired_width != b.desired_width) || (a.desired_height != b.desired_height);
+}
+
 void wayfire_layer_shell_view::commit()
 {
     wf::dimensions_t new_size{lsurface->surface->current.width, lsurface->surface->current.height};
@@ -551,16 +601,23 @@ void wayfire_layer_shell_view::commit()
 
     if (state->committed)
     {
+        auto& manager = wf_layer_shell_manager::get_instance();
         /* Update layer manually */
         if (prev_state.layer != state->layer)
         {
             wf::scene::readd_front(get_output()->node_for_layer(get_layer()), get_root_node());
             /* Will also trigger reflowing */
-            wf_layer_shell_manager::get_instance().handle_move_layer(this);
-        } else
+            manager.handle_move_layer(this);
+        } else if (placement_changed(prev_state, *state))
         {
-            /* Reflow reserved areas and positions */
-            wf_layer_shell_manager::get_instance().arrange_layers(get_output());
+            if ((prev_state.exclusive_zone > 0) || (state->exclusive_zone > 0))
+            {
+                /* Reflow reserved areas and positions */
+                manager.arrange_layer(get_output(), state->layer);
+            } else
+            {
+                manager.arrange_floating_view(this);
+            }
         }
 
         if (prev_state.keyboard_interactive != state->keyboard_interactive)
@@ -586,6 +643,7 @@ void wayfire_layer_shell_view::set_output(wf::output_t *output)
         // View's output is being destroyed, no point in reflowing
         // View is about to be mapped, no anchored area at all.
         this->remove_anchored(false);
+        last_configured.reset();
     }
 
     wf::view_interface_t::set_output(output);
@@ -633,6 +691,13 @@ void wayfire_layer_shell_view::configure(wf::geometry_t box)
         return;
     }
 
+    if (last_configured == box)
+    {
+        return;
+    }
+
+    last_configured = box;
+
     // TODO: transactions here could make sense, since we want to change x,y,w,h together, but have to wait
     // for the client to resize.
     move(box.x, box.y);
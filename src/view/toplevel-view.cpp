@@ -8,6 +8,7 @@
 #include <wayfire/window-manager.hpp>
 #include <wayfire/txn/transaction-manager.hpp>
 #include <wayfire/seat.hpp>
+#include <wayfire/nonstd/tracking-allocator.hpp>
 #include "view-impl.hpp"
 #include "wayfire/core.hpp"
 #include "wayfire/scene.hpp"
@@ -333,8 +334,14 @@ wayfire_toplevel_view wf::find_view_for_toplevel(
     std::shared_ptr<wf::toplevel_t> toplevel)
 {
     // FIXME: this could be a lot more efficient if we simply store a custom data on the toplevel.
-    for (auto& view : wf::get_core().get_all_views())
+    // The list has null entries for freed views if this is called from a for_each().
+    for (auto& view : wf::tracking_allocator_t<wf::view_interface_t>::get().get_all())
     {
+        if (!view)
+        {
+            continue;
+        }
+
         if (auto tview = toplevel_cast(view))
         {
             if (tview->toplevel() == toplevel)
@@ -191,6 +191,12 @@ static void transform_linear_damage(node_t *self, wf::region_t& damage)
 class view_2d_render_instance_t :
     public transformer_render_instance_t<view_2d_transformer_t>
 {
+    float get_content_scale(float target_scale)
+    {
+        float transform_scale = std::max(std::abs(self->get_scale_x()), std::abs(self->get_scale_y()));
+        return self->get_content_scale(target_scale, transform_scale);
+    }
+
   public:
     using transformer_render_instance_t::transformer_render_instance_t;
 
@@ -199,12 +205,17 @@ class view_2d_render_instance_t :
         transform_linear_damage(self.get(), damage);
     }
 
+    bool can_render_directly() override
+    {
+        return (std::abs(self->get_angle()) < 1e-3) && (self->get_alpha() >= 1.0f);
+    }
+
     void render(const wf::scene::render_instruction_t& data) override
     {
         if (std::abs(self->get_angle()) < 1e-3)
         {
             // No rotation, we can use render-agnostic functions.
-            auto tex = this->get_texture(data.target.scale);
+            auto tex = this->get_texture(get_content_scale(data.target.scale));
             tex.filter_mode = WLR_SCALE_FILTER_BILINEAR;
             auto bbox = self->get_bounding_box();
             data.pass->add_texture(tex, data.target, bbox, data.damage, self->get_alpha());
@@ -229,15 +240,18 @@ class view_2d_render_instance_t :
 
         data.pass->custom_gles_subpass([&]
         {
-            auto tex = wf::gles_texture_t{this->get_texture(data.target.scale)};
+            auto tex = wf::gles_texture_t{this->get_texture(get_content_scale(data.target.scale))};
             wf::gles::bind_render_buffer(data.target);
+            // Only the scissor box changes between the damaged rectangles
+            OpenGL::render_transformed_texture(tex, bbox, full_matrix,
+                glm::vec4{1.0, 1.0, 1.0, self->get_alpha()}, OpenGL::RENDER_FLAG_CACHED);
             for (auto& box : data.damage)
             {
                 wf::gles::render_target_logic_scissor(data.target, wlr_box_from_pixman_box(box));
-                // OpenGL::clear({1, 0, 0, 1});
-                OpenGL::render_transformed_texture(tex, bbox, full_matrix,
-                    glm::vec4{1.0, 1.0, 1.0, self->get_alpha()});
+                OpenGL::draw_cached();
             }
+
+            OpenGL::clear_cached();
         });
     }
 };
@@ -435,16 +449,26 @@ class view_3d_render_instance_t :
 
         transform =
             wf::gles::render_target_gl_to_framebuffer(data.target) * scale * translate * transform;
+        // The perspective makes the scale vary across the view, use the
+        // scale of its bounding box as an estimate.
+        auto tbox = self->get_bounding_box();
+        float transform_scale = std::max(1.0f * tbox.width / std::max(bbox.width, 1),
+            1.0f * tbox.height / std::max(bbox.height, 1));
+        float content_scale = self->get_content_scale(data.target.scale, transform_scale);
+
         data.pass->custom_gles_subpass([&]
         {
-            auto tex = wf::gles_texture_t{get_texture(data.target.scale)};
+            auto tex = wf::gles_texture_t{get_texture(content_scale)};
             wf::gles::bind_render_buffer(data.target);
+            OpenGL::render_transformed_texture(tex, quad.geometry, {},
+                transform, self->color, OpenGL::RENDER_FLAG_CACHED);
             for (auto& box : data.damage)
             {
                 wf::gles::render_target_logic_scissor(data.target, wlr_box_from_pixman_box(box));
-                OpenGL::render_transformed_texture(tex, quad.geometry, {},
-                    transform, self->color);
+                OpenGL::draw_cached();
             }
+
+            OpenGL::clear_cached();
         });
     }
 };
@@ -501,6 +525,40 @@ wf::texture_t transformer_base_node_t::get_updated_contents(const wf::geometry_t
     return wf::texture_t{inner_content.get_texture(), {}};
 }
 
+float transformer_base_node_t::get_content_scale(float target_scale, float transform_scale)
+{
+    // Scales are rounded up to 1/16 steps, so that the buffer size changes
+    // only in discrete steps.
+    static constexpr float STEP = 1.0f / 16;
+    static constexpr int SETTLE_FRAMES = 5;
+    // How far the buffer scale may be off in either direction during an animation
+    static constexpr float MAX_RATIO = 1.5f;
+
+    float wanted = std::ceil(target_scale * transform_scale / STEP) * STEP;
+    wanted = std::min(target_scale, std::max(wanted, STEP));
+
+    auto& state = content_scales[target_scale];
+    state.settled_frames  = (wanted == state.requested_scale) ? state.settled_frames + 1 : 0;
+    state.requested_scale = wanted;
+
+    const bool far_off = (wanted * MAX_RATIO < state.content_scale) ||
+        (wanted > state.content_scale * MAX_RATIO);
+    if ((state.content_scale <= 0.0f) || far_off || (state.settled_frames >= SETTLE_FRAMES))
+    {
+        state.content_scale = wanted;
+    } else if (wanted != state.content_scale)
+    {
+        // Make sure that more frames are rendered, otherwise a transform
+        // which stopped changing would keep a blurry or oversized buffer.
+        settle_idle.run_once([=] ()
+        {
+            wf::scene::damage_node(this, get_bounding_box());
+        });
+    }
+
+    return state.content_scale;
+}
+
 void transformer_base_node_t::release_buffers()
 {
     inner_content.free();
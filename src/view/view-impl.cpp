@@ -306,24 +306,18 @@ std::optional<wf::scene::layer> wf::get_view_layer(wayfire_view view)
 void wf::view_bring_to_front(wayfire_view view)
 {
     wf::scene::node_t *node = view->get_root_node().get();
-    wf::scene::node_t *damage_from = nullptr;
-    bool actual_update = false;
 
+    // Each raise damages only the parts of the view which were covered before,
+    // see node_t::set_children_unchecked().
     while (node->parent())
     {
         if (!node->is_structure_node() && dynamic_cast<scene::floating_inner_node_t*>(node->parent()))
         {
-            damage_from    = node->parent();
-            actual_update |= wf::scene::raise_to_front(node->shared_from_this());
+            wf::scene::raise_to_front(node->shared_from_this());
         }
 
         node = node->parent();
     }
-
-    if (damage_from && actual_update)
-    {
-        wf::scene::damage_node(damage_from->shared_from_this(), damage_from->get_bounding_box());
-    }
 }
 
 static void gather_views(wf::scene::node_ptr root, std::vector<wayfire_view>& views)
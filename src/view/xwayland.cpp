@@ -251,7 +251,7 @@ void wf::init_xwayland(bool lazy)
         if (!script.empty())
         {
             LOGD("Executing XWayland startup script: ", script);
-            wf::get_core().run(script);
+            wf::get_core().run_async(script);
         }
     });
 
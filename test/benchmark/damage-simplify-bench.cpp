@@ -0,0 +1,185 @@
+/**
+ * Replays damage traces through wf::region_t::simplify() and reports how many
+ * rects remain per frame, how much the repainted area grows and how long the
+ * simplification takes.
+ *
+ * Traces can be recorded by running Wayfire with WAYFIRE_DAMAGE_TRACE=<file>
+ * and passed with --trace <file>. Without traces, synthetic traces resembling
+ * a terminal, a spreadsheet and an editor are used.
+ *
+ * Usage:
+ *   damage-simplify-bench [--trace file]...
+ */
+#include <wayfire/region.hpp>
+#include <wayfire/nonstd/json.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct damage_trace_t
+{
+    std::string name;
+    std::vector<wf::region_t> frames;
+};
+
+static damage_trace_t load_trace(const std::string& path)
+{
+    damage_trace_t trace;
+    trace.name = path;
+
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string output;
+        int nr_rects = 0;
+        fields >> output >> nr_rects;
+
+        wf::region_t frame;
+        for (int i = 0; i < nr_rects; i++)
+        {
+            wf::geometry_t box;
+            fields >> box.x >> box.y >> box.width >> box.height;
+            frame |= box;
+        }
+
+        trace.frames.push_back(std::move(frame));
+    }
+
+    return trace;
+}
+
+/**
+ * Generate a trace where each frame damages @cells_per_frame cells of a grid,
+ * in runs of @run_length consecutive cells (e.g. a word being typed, or a row
+ * of spreadsheet cells being recalculated).
+ */
+static damage_trace_t synthetic_trace(std::string name, wf::dimensions_t cell, wf::dimensions_t gap,
+    int columns, int rows, int cells_per_frame, int run_length)
+{
+    damage_trace_t trace;
+    trace.name = name;
+
+    uint32_t seed = 1;
+    auto next_random = [&] ()
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7fff;
+    };
+
+    for (int f = 0; f < 300; f++)
+    {
+        wf::region_t frame;
+        for (int c = 0; c < cells_per_frame; c += run_length)
+        {
+            int row    = next_random() % rows;
+            int column = next_random() % columns;
+            for (int i = 0; i < run_length && column + i < columns; i++)
+            {
+                frame |= wf::geometry_t{
+                    (column + i) * (cell.width + gap.width),
+                    row * (cell.height + gap.height),
+                    cell.width, cell.height,
+                };
+            }
+        }
+
+        trace.frames.push_back(std::move(frame));
+    }
+
+    return trace;
+}
+
+static int64_t region_area(const wf::region_t& region)
+{
+    int64_t area = 0;
+    for (const auto& box : region)
+    {
+        area += int64_t(box.x2 - box.x1) * (box.y2 - box.y1);
+    }
+
+    return area;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<damage_trace_t> traces;
+    for (int i = 1; i < argc; i++)
+    {
+        if ((std::string(argv[i]) == "--trace") && (i + 1 < argc))
+        {
+            traces.push_back(load_trace(argv[++i]));
+        } else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--trace file]..." << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (traces.empty())
+    {
+        // Blinking cursors and glyphs with a 1px gap between them
+        traces.push_back(synthetic_trace("terminal", {9, 18}, {1, 1}, 200, 55, 120, 6));
+        // Cells with a 1px grid line between them, recalculated in rows
+        traces.push_back(synthetic_trace("spreadsheet", {80, 20}, {1, 1}, 24, 50, 300, 12));
+        // Scattered diagnostics and highlights
+        traces.push_back(synthetic_trace("editor", {30, 17}, {4, 3}, 60, 60, 80, 2));
+    }
+
+    struct policy_t
+    {
+        double overhead;
+        int max_rects;
+    };
+
+    const policy_t policies[] = {{0.0, 0}, {0.1, 0}, {0.25, 0}, {0.1, 32}, {0.0, 16}};
+
+    wf::json_t report = wf::json_t::array();
+    for (auto& trace : traces)
+    {
+        for (auto& policy : policies)
+        {
+            int64_t rects_before = 0, rects_after = 0;
+            int64_t area_before  = 0, area_after = 0;
+            std::chrono::duration<double, std::micro> duration{0};
+
+            for (const auto& frame : trace.frames)
+            {
+                wf::region_t simplified = frame;
+                auto start = std::chrono::steady_clock::now();
+                simplified.simplify(policy.overhead, policy.max_rects);
+                duration += std::chrono::steady_clock::now() - start;
+
+                rects_before += frame.rect_count();
+                rects_after  += simplified.rect_count();
+                area_before  += region_area(frame);
+                area_after   += region_area(simplified);
+            }
+
+            const double nr_frames = std::max<size_t>(1, trace.frames.size());
+            wf::json_t entry;
+            entry["trace"]     = trace.name;
+            entry["overhead"]  = policy.overhead;
+            entry["max-rects"] = policy.max_rects;
+            entry["rects-before"]  = rects_before / nr_frames;
+            entry["rects-after"]   = rects_after / nr_frames;
+            entry["area-increase"] = area_before ? (double)area_after / area_before - 1.0 : 0.0;
+            entry["simplify-us"]   = duration.count() / nr_frames;
+            report.append(entry);
+        }
+    }
+
+    report.map_serialized([] (const char *buffer, size_t size)
+    {
+        std::cout.write(buffer, size);
+        std::cout << std::endl;
+    });
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+/**
+ * Compares the batch damage transforms of render_target_t with transforming
+ * and unioning each box separately, for damage with 1 to 500 rects.
+ *
+ * The output is a JSON document with the average time per call in microseconds.
+ */
+#include <wayfire/render.hpp>
+#include <wayfire/region.hpp>
+#include <wayfire/nonstd/json.hpp>
+
+#include <chrono>
+#include <iostream>
+
+static wf::region_t make_damage(wf::geometry_t area, int nr_rects)
+{
+    wf::region_t damage;
+    for (int i = 0; i < nr_rects; i++)
+    {
+        // Glyph-sized rects spread over a grid, similar to the damage of a terminal
+        int x = area.x + (i * 24) % (area.width - 16);
+        int y = area.y + 18 * ((i * 24) / (area.width - 16));
+        damage |= wf::geometry_t{x, y, 12, 16};
+    }
+
+    return damage;
+}
+
+template<class Callback>
+static double measure_us(int iterations, Callback&& callback)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        callback();
+    }
+
+    std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - start;
+    return duration.count() / iterations;
+}
+
+int main()
+{
+    wf::render_target_t target{wf::render_buffer_t{nullptr, {2160, 3840}}};
+    target.geometry     = {0, 0, 2560, 1440};
+    target.scale = 1.5;
+    target.wl_transform = WL_OUTPUT_TRANSFORM_90;
+
+    wf::json_t report = wf::json_t::array();
+    for (int nr_rects : {1, 10, 50, 100, 250, 500})
+    {
+        auto damage = make_damage(target.geometry, nr_rects);
+        const int iterations = 200'000 / nr_rects;
+
+        double batch_us = measure_us(iterations, [&]
+        {
+            auto result = target.framebuffer_region_from_geometry_region(damage);
+        });
+
+        double per_box_us = measure_us(iterations, [&]
+        {
+            wf::region_t result;
+            for (const auto& rect : damage)
+            {
+                result |= target.framebuffer_box_from_geometry_box(wlr_box_from_pixman_box(rect));
+            }
+        });
+
+        wf::json_t entry;
+        entry["rects"] = nr_rects;
+        entry["batch-us"]   = batch_us;
+        entry["per-box-us"] = per_box_us;
+        report.append(entry);
+    }
+
+    report.map_serialized([] (const char *buffer, size_t size)
+    {
+        std::cout.write(buffer, size);
+        std::cout << std::endl;
+    });
+
+    return 0;
+}
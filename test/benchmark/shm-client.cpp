@@ -0,0 +1,266 @@
+/**
+ * A minimal xdg-shell client with a wl_shm buffer, used by wf-bench.
+ *
+ * The client opens a single toplevel and, unless --static is given, repaints a
+ * small square on every frame callback, so that each frame carries a small
+ * amount of client damage, similar to a terminal with a blinking cursor.
+ */
+#include <wayland-client.h>
+#include "xdg-shell-client-protocol.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+struct client_state_t
+{
+    wl_display *display = nullptr;
+    wl_compositor *compositor = nullptr;
+    wl_shm *shm = nullptr;
+    xdg_wm_base *wm_base = nullptr;
+
+    wl_surface *surface = nullptr;
+    xdg_surface *xdg_surf = nullptr;
+    xdg_toplevel *toplevel = nullptr;
+
+    wl_buffer *buffer = nullptr;
+    uint32_t *pixels  = nullptr;
+    int width  = 400;
+    int height = 300;
+    int pending_width  = 0;
+    int pending_height = 0;
+
+    bool animate = true;
+    bool running = true;
+    uint32_t frame_counter = 0;
+};
+
+static void handle_wm_base_ping(void*, xdg_wm_base *wm_base, uint32_t serial)
+{
+    xdg_wm_base_pong(wm_base, serial);
+}
+
+static const xdg_wm_base_listener wm_base_listener = {
+    .ping = handle_wm_base_ping,
+};
+
+static void handle_global(void *data, wl_registry *registry, uint32_t name,
+    const char *interface, uint32_t version)
+{
+    auto state = (client_state_t*)data;
+    if (!strcmp(interface, wl_compositor_interface.name))
+    {
+        state->compositor = (wl_compositor*)wl_registry_bind(registry, name, &wl_compositor_interface, 4);
+    } else if (!strcmp(interface, wl_shm_interface.name))
+    {
+        state->shm = (wl_shm*)wl_registry_bind(registry, name, &wl_shm_interface, 1);
+    } else if (!strcmp(interface, xdg_wm_base_interface.name))
+    {
+        state->wm_base = (xdg_wm_base*)wl_registry_bind(registry, name, &xdg_wm_base_interface, 1);
+        xdg_wm_base_add_listener(state->wm_base, &wm_base_listener, state);
+    }
+}
+
+static void handle_global_remove(void*, wl_registry*, uint32_t)
+{}
+
+static const wl_registry_listener registry_listener = {
+    .global = handle_global,
+    .global_remove = handle_global_remove,
+};
+
+static void handle_buffer_release(void*, wl_buffer*)
+{}
+
+static const wl_buffer_listener buffer_listener = {
+    .release = handle_buffer_release,
+};
+
+static bool allocate_buffer(client_state_t *state)
+{
+    if (state->buffer)
+    {
+        wl_buffer_destroy(state->buffer);
+        munmap(state->pixels, state->width * state->height * 4);
+        state->buffer = nullptr;
+    }
+
+    int stride = state->width * 4;
+    int size   = stride * state->height;
+    int fd     = memfd_create("wf-bench-client", MFD_CLOEXEC);
+    if ((fd < 0) || (ftruncate(fd, size) < 0))
+    {
+        perror("wf-bench-client: failed to create shm file");
+        return false;
+    }
+
+    state->pixels = (uint32_t*)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (state->pixels == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    auto pool = wl_shm_create_pool(state->shm, fd, size);
+    state->buffer = wl_shm_pool_create_buffer(pool, 0, state->width, state->height, stride,
+        WL_SHM_FORMAT_XRGB8888);
+    wl_buffer_add_listener(state->buffer, &buffer_listener, state);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+
+    for (int i = 0; i < state->width * state->height; i++)
+    {
+        state->pixels[i] = 0xff336699;
+    }
+
+    return true;
+}
+
+static void draw_frame(client_state_t *state);
+static void handle_frame_done(void *data, wl_callback *callback, uint32_t)
+{
+    wl_callback_destroy(callback);
+    draw_frame((client_state_t*)data);
+}
+
+static const wl_callback_listener frame_listener = {
+    .done = handle_frame_done,
+};
+
+static void draw_frame(client_state_t *state)
+{
+    const int square = 16;
+    int x = (state->frame_counter * 4) % std::max(1, state->width - square);
+    int y = state->height / 2;
+    uint32_t color = (state->frame_counter & 1) ? 0xffcc3333 : 0xff33cc33;
+    for (int j = y; j < std::min(y + square, state->height); j++)
+    {
+        for (int i = x; i < x + square; i++)
+        {
+            state->pixels[j * state->width + i] = color;
+        }
+    }
+
+    ++state->frame_counter;
+    wl_surface_attach(state->surface, state->buffer, 0, 0);
+    wl_surface_damage_buffer(state->surface, x, y, square, square);
+    if (state->animate)
+    {
+        auto callback = wl_surface_frame(state->surface);
+        wl_callback_add_listener(callback, &frame_listener, state);
+    }
+
+    wl_surface_commit(state->surface);
+}
+
+static void handle_xdg_surface_configure(void *data, xdg_surface *xdg_surf, uint32_t serial)
+{
+    auto state = (client_state_t*)data;
+    xdg_surface_ack_configure(xdg_surf, serial);
+
+    bool resized = false;
+    if ((state->pending_width > 0) && (state->pending_height > 0) &&
+        ((state->pending_width != state->width) || (state->pending_height != state->height)))
+    {
+        state->width  = state->pending_width;
+        state->height = state->pending_height;
+        resized = true;
+    }
+
+    if (!state->buffer || resized)
+    {
+        if (!allocate_buffer(state))
+        {
+            state->running = false;
+            return;
+        }
+
+        wl_surface_attach(state->surface, state->buffer, 0, 0);
+        wl_surface_damage_buffer(state->surface, 0, 0, state->width, state->height);
+        if (state->frame_counter == 0)
+        {
+            draw_frame(state);
+            return;
+        }
+    }
+
+    wl_surface_commit(state->surface);
+}
+
+static const xdg_surface_listener xdg_surf_listener = {
+    .configure = handle_xdg_surface_configure,
+};
+
+static void handle_toplevel_configure(void *data, xdg_toplevel*, int32_t width, int32_t height, wl_array*)
+{
+    auto state = (client_state_t*)data;
+    state->pending_width  = width;
+    state->pending_height = height;
+}
+
+static void handle_toplevel_close(void *data, xdg_toplevel*)
+{
+    ((client_state_t*)data)->running = false;
+}
+
+static const xdg_toplevel_listener toplevel_listener = {
+    .configure = handle_toplevel_configure,
+    .close     = handle_toplevel_close,
+};
+
+int main(int argc, char **argv)
+{
+    client_state_t state;
+    std::string title = "wf-bench-client";
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--title") && (i + 1 < argc))
+        {
+            title = argv[++i];
+        } else if (arg == "--static")
+        {
+            state.animate = false;
+        } else if ((arg == "--size") && (i + 2 < argc))
+        {
+            state.width  = std::atoi(argv[++i]);
+            state.height = std::atoi(argv[++i]);
+        }
+    }
+
+    state.display = wl_display_connect(nullptr);
+    if (!state.display)
+    {
+        fprintf(stderr, "wf-bench-client: failed to connect to the wayland display\n");
+        return EXIT_FAILURE;
+    }
+
+    auto registry = wl_display_get_registry(state.display);
+    wl_registry_add_listener(registry, &registry_listener, &state);
+    wl_display_roundtrip(state.display);
+    if (!state.compositor || !state.shm || !state.wm_base)
+    {
+        fprintf(stderr, "wf-bench-client: compositor lacks wl_compositor, wl_shm or xdg_wm_base\n");
+        return EXIT_FAILURE;
+    }
+
+    state.surface  = wl_compositor_create_surface(state.compositor);
+    state.xdg_surf = xdg_wm_base_get_xdg_surface(state.wm_base, state.surface);
+    xdg_surface_add_listener(state.xdg_surf, &xdg_surf_listener, &state);
+    state.toplevel = xdg_surface_get_toplevel(state.xdg_surf);
+    xdg_toplevel_add_listener(state.toplevel, &toplevel_listener, &state);
+    xdg_toplevel_set_title(state.toplevel, title.c_str());
+    xdg_toplevel_set_app_id(state.toplevel, "wf-bench-client");
+    wl_surface_commit(state.surface);
+
+    while (state.running && (wl_display_dispatch(state.display) != -1))
+    {}
+
+    wl_display_disconnect(state.display);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,847 @@
+/**
+ * wf-bench: a headless performance regression harness.
+ *
+ * wf-bench starts Wayfire on the headless backend, spawns a number of simple
+ * SHM clients and replays scripted scenarios through the stipc plugin. For each
+ * scenario it reports frame times, CPU time per frame, the number of damage
+ * rects per frame before and after simplification and the number of IPC
+ * events emitted, as a JSON document on stdout (or in the file given with
+ * --output). With --alloc-stats, Wayfire is started with allocation accounting
+ * (which requires building it with -Dalloc_stats=true)
+ * and the number of heap allocations per frame is reported as well.
+ *
+ * The color-filter-4k scenario is not run by default, it measures the
+ * postprocessing chain and is meant to be run with --renderer gles2. The
+ * tile-relayout scenario is not run by default either, it tiles 30 views and
+ * alternates between two layouts of them. The ipc-events scenario, also not
+ * run by default, moves 200 views over IPC and reports how many IPC events
+ * per second are delivered; compare it between builds to measure the cost of
+ * serializing views. The spawn scenario starts short-lived processes over IPC
+ * and reports how long each stipc/run call takes, next to the frame times.
+ *
+ * Usage:
+ *   wf-bench --wayfire <path> --client <path> [--clients N] [--renderer pixman|gles2]
+ *            [--scenario name]... [--output file.json] [--alloc-stats]
+ */
+#include <wayfire/nonstd/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr int HEADER_LEN = 4;
+
+/**
+ * A blocking connection to Wayfire's IPC socket.
+ */
+class ipc_connection_t
+{
+  public:
+    ~ipc_connection_t()
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    bool connect(const std::string& path, int timeout_ms)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+            if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0)
+            {
+                return true;
+            }
+
+            close(fd);
+            fd = -1;
+            usleep(50'000);
+        }
+
+        return false;
+    }
+
+    wf::json_t call(const std::string& method, const wf::json_t& data = wf::json_t())
+    {
+        wf::json_t message;
+        message["method"] = method;
+        message["data"]   = data;
+        send(message);
+
+        auto response = receive(-1);
+        if (!response)
+        {
+            throw std::runtime_error("IPC connection closed while calling " + method);
+        }
+
+        if (response->has_member("error"))
+        {
+            throw std::runtime_error(method + ": " + (*response)["error"].as_string());
+        }
+
+        return *response;
+    }
+
+    /**
+     * Read all messages which are currently pending or arrive in the next
+     * @timeout_ms milliseconds.
+     *
+     * @return The number of messages read.
+     */
+    int drain(int timeout_ms)
+    {
+        int count = 0;
+        while (receive(timeout_ms))
+        {
+            ++count;
+            timeout_ms = 0;
+        }
+
+        return count;
+    }
+
+    void send(const wf::json_t& message)
+    {
+        message.map_serialized([&] (const char *buffer, size_t size)
+        {
+            uint32_t len = size;
+            write_exact((const char*)&len, HEADER_LEN);
+            write_exact(buffer, len);
+        });
+    }
+
+  private:
+    int fd = -1;
+
+    void write_exact(const char *buf, size_t n)
+    {
+        while (n > 0)
+        {
+            ssize_t w = write(fd, buf, n);
+            if (w <= 0)
+            {
+                throw std::runtime_error("Failed to write to the IPC socket");
+            }
+
+            n   -= w;
+            buf += w;
+        }
+    }
+
+    bool read_exact(char *buf, size_t n)
+    {
+        while (n > 0)
+        {
+            ssize_t r = read(fd, buf, n);
+            if (r <= 0)
+            {
+                return false;
+            }
+
+            n   -= r;
+            buf += r;
+        }
+
+        return true;
+    }
+
+    std::optional<wf::json_t> receive(int timeout_ms)
+    {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, timeout_ms) <= 0)
+        {
+            return {};
+        }
+
+        uint32_t len;
+        if (!read_exact((char*)&len, HEADER_LEN))
+        {
+            return {};
+        }
+
+        std::string buffer(len, '\0');
+        if (!read_exact(buffer.data(), len))
+        {
+            return {};
+        }
+
+        wf::json_t result;
+        if (auto err = wf::json_t::parse_string(buffer, result))
+        {
+            throw std::runtime_error("Failed to parse IPC message: " + *err);
+        }
+
+        return result;
+    }
+};
+
+struct bench_options_t
+{
+    std::string wayfire = "wayfire";
+    std::string client;
+    std::string renderer = "pixman";
+    std::string output;
+    std::vector<std::string> scenarios;
+    int nr_clients   = 10;
+    bool alloc_stats = false;
+};
+
+/**
+ * Summary statistics of a series of samples.
+ */
+static wf::json_t summarize(std::vector<double> samples)
+{
+    wf::json_t result;
+    result["count"] = (int64_t)samples.size();
+    if (samples.empty())
+    {
+        return result;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&] (double p)
+    {
+        size_t idx = std::min(samples.size() - 1, size_t(p * (samples.size() - 1) + 0.5));
+        return samples[idx];
+    };
+
+    result["mean"] = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    result["p50"]  = percentile(0.50);
+    result["p95"]  = percentile(0.95);
+    result["p99"]  = percentile(0.99);
+    result["max"]  = samples.back();
+    return result;
+}
+
+class benchmark_t
+{
+  public:
+    benchmark_t(bench_options_t options) : options(options)
+    {}
+
+    ~benchmark_t()
+    {
+        stop_wayfire();
+    }
+
+    wf::json_t run()
+    {
+        start_wayfire();
+        setup_outputs();
+
+        wf::json_t report;
+        report["renderer"] = options.renderer;
+        report["clients"]  = options.nr_clients;
+        report["scenarios"] = wf::json_t();
+
+        spawn_clients(options.nr_clients);
+        for (auto& name : options.scenarios)
+        {
+            std::cerr << "wf-bench: running scenario " << name << std::endl;
+            report["scenarios"][name] = run_scenario(name);
+        }
+
+        return report;
+    }
+
+  private:
+    bench_options_t options;
+    pid_t wayfire_pid = -1;
+    std::string runtime_dir;
+    ipc_connection_t ipc;
+    ipc_connection_t events;
+    int spawned_clients = 0;
+    uint64_t output_id  = 0;
+
+    /* Round trip times of stipc/run in the spawn scenario */
+    std::vector<double> spawn_ms;
+
+    /* The 4K output created for the color-filter-4k scenario */
+    struct
+    {
+        uint64_t id = 0;
+        int x = 0, y = 0, width = 0, height = 0;
+    } filter_output;
+
+    static constexpr const char *CONFIG =
+        "[core]\n"
+        "plugins = ipc ipc-rules stipc move expo scale vswitch simple-tile\n"
+        "vwidth = 3\n"
+        "vheight = 3\n"
+        "[simple-tile]\n"
+        "tile_by_default = none\n"
+        "animation_duration = 300\n"
+        "[input]\n"
+        "xkb_layout = us\n";
+
+    void start_wayfire()
+    {
+        char tmpl[] = "/tmp/wf-bench-XXXXXX";
+        if (!mkdtemp(tmpl))
+        {
+            throw std::runtime_error("Failed to create a temporary directory");
+        }
+
+        runtime_dir = tmpl;
+        std::ofstream(runtime_dir + "/wayfire.ini") << CONFIG;
+        const std::string socket = runtime_dir + "/wayfire.socket";
+
+        wayfire_pid = fork();
+        if (wayfire_pid == 0)
+        {
+            setenv("WLR_BACKENDS", "headless", 1);
+            setenv("WLR_RENDERER", options.renderer.c_str(), 1);
+            setenv("WLR_LIBINPUT_NO_DEVICES", "1", 1);
+            setenv("WAYFIRE_CONFIG_FILE", (runtime_dir + "/wayfire.ini").c_str(), 1);
+            setenv("_WAYFIRE_SOCKET", socket.c_str(), 1);
+            setenv("XDG_RUNTIME_DIR", runtime_dir.c_str(), 1);
+            unsetenv("WAYLAND_DISPLAY");
+            unsetenv("DISPLAY");
+
+            auto log = (runtime_dir + "/wayfire.log");
+            if (!freopen(log.c_str(), "w", stdout) || !freopen(log.c_str(), "a", stderr))
+            {
+                _exit(127);
+            }
+
+            execlp(options.wayfire.c_str(), options.wayfire.c_str(),
+                options.alloc_stats ? "--alloc-stats" : nullptr, nullptr);
+            _exit(127);
+        }
+
+        if (!ipc.connect(socket, 10'000) || !events.connect(socket, 1000))
+        {
+            throw std::runtime_error("Failed to connect to Wayfire, see " + runtime_dir + "/wayfire.log");
+        }
+
+        wf::json_t watch;
+        watch["events"] = wf::json_t::array();
+        events.call("window-rules/events/watch", watch);
+    }
+
+    void stop_wayfire()
+    {
+        if (wayfire_pid > 0)
+        {
+            kill(wayfire_pid, SIGTERM);
+            waitpid(wayfire_pid, nullptr, 0);
+            wayfire_pid = -1;
+        }
+    }
+
+    void setup_outputs()
+    {
+        auto outputs = ipc.call("window-rules/list-outputs");
+        if (outputs.size() == 0)
+        {
+            wf::json_t data;
+            data["width"]  = 1920;
+            data["height"] = 1080;
+            ipc.call("wayfire/create-headless-output", data);
+            outputs = ipc.call("window-rules/list-outputs");
+        }
+
+        output_id = outputs[size_t(0)]["id"].as_uint64();
+    }
+
+    int count_views()
+    {
+        auto views = ipc.call("window-rules/list-views");
+        int count  = 0;
+        for (size_t i = 0; i < views.size(); i++)
+        {
+            if (views[i]["mapped"].as_bool() && (views[i]["app-id"].as_string() == "wf-bench-client"))
+            {
+                ++count;
+            }
+        }
+
+        return count;
+    }
+
+    void spawn_clients(int target)
+    {
+        for (; spawned_clients < target; spawned_clients++)
+        {
+            wf::json_t data;
+            data["cmd"] = options.client + " --title wf-bench-" + std::to_string(spawned_clients);
+            ipc.call("stipc/run", data);
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (count_views() < target)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                throw std::runtime_error("Timed out waiting for clients to map");
+            }
+
+            wait_ms(100);
+        }
+    }
+
+    /** Wait for the given time, while consuming IPC events so that the socket does not overflow. */
+    int wait_ms(int ms)
+    {
+        int count    = 0;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            count += events.drain(std::max<int>(1, left.count()));
+        }
+
+        return count;
+    }
+
+    void move_cursor(double x, double y)
+    {
+        wf::json_t data;
+        data["x"] = x;
+        data["y"] = y;
+        ipc.call("stipc/move_cursor", data);
+    }
+
+    void feed_button(const std::string& combo, const std::string& mode)
+    {
+        wf::json_t data;
+        data["combo"] = combo;
+        data["mode"]  = mode;
+        ipc.call("stipc/feed_button", data);
+    }
+
+    void set_workspace(int x, int y)
+    {
+        wf::json_t data;
+        data["x"] = x;
+        data["y"] = y;
+        data["output-id"] = output_id;
+        ipc.call("vswitch/set-workspace", data);
+    }
+
+    int scenario_move_drag()
+    {
+        wf::json_t views = ipc.call("window-rules/list-views");
+        wf::json_t geometry = views[size_t(0)]["geometry"];
+        double x = geometry["x"].as_int() + geometry["width"].as_int() / 2.0;
+        double y = geometry["y"].as_int() + geometry["height"].as_int() / 2.0;
+
+        int ev_count = 0;
+        move_cursor(x, y);
+        feed_button("S-BTN_LEFT", "press");
+        for (int i = 0; i < 240; i++)
+        {
+            // Simulate a high-frequency mouse: several motion events per frame.
+            x += (i < 120) ? 3 : -3;
+            y += (i < 120) ? 1 : -1;
+            move_cursor(x, y);
+            ev_count += wait_ms(2);
+        }
+
+        feed_button("S-BTN_LEFT", "release");
+        return ev_count + wait_ms(200);
+    }
+
+    int scenario_toggle(const std::string& method, int duration_ms)
+    {
+        int ev_count = 0;
+        ipc.call(method);
+        ev_count += wait_ms(duration_ms);
+        ipc.call(method);
+        ev_count += wait_ms(duration_ms);
+        return ev_count;
+    }
+
+    int scenario_workspace_switch()
+    {
+        int ev_count = 0;
+        const std::vector<std::pair<int, int>> path = {{1, 0}, {1, 1}, {0, 1}, {0, 0}};
+        for (auto& [x, y] : path)
+        {
+            set_workspace(x, y);
+            ev_count += wait_ms(400);
+        }
+
+        return ev_count;
+    }
+
+    /**
+     * Move the cursor in small steps over a 4K output with a color filter, so
+     * that each frame has only cursor-sized damage to postprocess.
+     */
+    int scenario_color_filter()
+    {
+        int ev_count = 0;
+        for (int i = 0; i < 240; i++)
+        {
+            double angle = i * 2 * M_PI / 120;
+            move_cursor(filter_output.x + filter_output.width / 2 + 200 * std::cos(angle),
+                filter_output.y + filter_output.height / 2 + 200 * std::sin(angle));
+            ev_count += wait_ms(8);
+        }
+
+        return ev_count;
+    }
+
+    /**
+     * Tile 30 views in three columns on the current workspace, and switch
+     * between two layouts which resize some of them and only move others.
+     */
+    int scenario_tile_relayout()
+    {
+        static constexpr int NR_TILED = 30;
+        static constexpr int COLUMNS  = 3;
+
+        std::vector<uint64_t> ids;
+        int64_t wset_index = 0;
+        auto views = ipc.call("window-rules/list-views");
+        for (size_t i = 0; (i < views.size()) && (ids.size() < NR_TILED); i++)
+        {
+            if (views[i]["mapped"].as_bool() && (views[i]["app-id"].as_string() == "wf-bench-client"))
+            {
+                ids.push_back(views[i]["id"].as_uint64());
+                wset_index = views[i]["wset-index"].as_int64();
+            }
+        }
+
+        auto make_layout = [&] (int variant)
+        {
+            wf::json_t columns = wf::json_t::array();
+            for (int c = 0; c < COLUMNS; c++)
+            {
+                wf::json_t rows = wf::json_t::array();
+                for (size_t r = c; r < ids.size(); r += COLUMNS)
+                {
+                    wf::json_t leaf;
+                    leaf["view-id"] = ids[r];
+                    // The first row changes its height, which moves all rows below it
+                    leaf["weight"] = ((r < COLUMNS) && variant) ? 3.0 : 1.0;
+                    rows.append(leaf);
+                }
+
+                wf::json_t column;
+                column["horizontal-split"] = rows;
+                // Only the middle column changes its width
+                column["weight"] = ((c == 1) && variant) ? 2.0 : 1.0;
+                columns.append(column);
+            }
+
+            wf::json_t data;
+            data["wset-index"] = wset_index;
+            data["workspace"]["x"] = 0;
+            data["workspace"]["y"] = 0;
+            data["layout"]["vertical-split"] = columns;
+            return data;
+        };
+
+        set_workspace(0, 0);
+        ipc.call("simple-tile/set-layout", make_layout(0));
+        int ev_count = wait_ms(400);
+        for (int i = 1; i <= 10; i++)
+        {
+            ipc.call("simple-tile/set-layout", make_layout(i % 2));
+            ev_count += wait_ms(400);
+        }
+
+        return ev_count;
+    }
+
+    /**
+     * Move 200 views back and forth with configure-view, so that each move
+     * emits events which serialize the view.
+     */
+    int scenario_ipc_events()
+    {
+        std::vector<uint64_t> ids;
+        wf::json_t fields;
+        fields["fields"] = wf::json_t::array();
+        fields["fields"].append("id");
+        fields["fields"].append("app-id");
+        auto views = ipc.call("window-rules/list-views", fields);
+        for (size_t i = 0; i < views.size(); i++)
+        {
+            if (views[i]["app-id"].as_string() == "wf-bench-client")
+            {
+                ids.push_back(views[i]["id"].as_uint64());
+            }
+        }
+
+        int ev_count = 0;
+        for (int round = 0; round < 20; round++)
+        {
+            for (size_t i = 0; i < ids.size(); i++)
+            {
+                wf::json_t data;
+                data["id"] = ids[i];
+                data["geometry"]["x"] = int(i % 20) * 40 + (round % 2) * 10;
+                data["geometry"]["y"] = int(i / 20) * 40;
+                data["geometry"]["width"]  = 300;
+                data["geometry"]["height"] = 200;
+                ipc.call("window-rules/configure-view", data);
+                ev_count += events.drain(0);
+            }
+
+            ev_count += wait_ms(50);
+        }
+
+        return ev_count + wait_ms(200);
+    }
+
+    /**
+     * Start 200 processes which exit immediately, while the views are shown,
+     * and measure how long each request takes.
+     */
+    int scenario_spawn()
+    {
+        int ev_count = 0;
+        spawn_ms.clear();
+        for (int i = 0; i < 200; i++)
+        {
+            wf::json_t data;
+            data["cmd"] = "true";
+            auto start = std::chrono::steady_clock::now();
+            ipc.call("stipc/run", data);
+            spawn_ms.push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count());
+            ev_count += wait_ms(10);
+        }
+
+        return ev_count;
+    }
+
+    void setup_color_filter(bool enable)
+    {
+        wf::json_t data;
+        if (enable)
+        {
+            data["width"]  = 3840;
+            data["height"] = 2160;
+            auto output = ipc.call("wayfire/create-headless-output", data)["output"];
+            filter_output.id     = output["id"].as_uint64();
+            filter_output.x      = output["geometry"]["x"].as_int();
+            filter_output.y      = output["geometry"]["y"].as_int();
+            filter_output.width  = output["geometry"]["width"].as_int();
+            filter_output.height = output["geometry"]["height"].as_int();
+        }
+
+        data = wf::json_t();
+        data["enable"]    = enable;
+        data["output-id"] = filter_output.id;
+        ipc.call("stipc/color_filter", data);
+
+        if (!enable)
+        {
+            data = wf::json_t();
+            data["output-id"] = filter_output.id;
+            ipc.call("wayfire/destroy-headless-output", data);
+        }
+    }
+
+    wf::json_t run_scenario(const std::string& name)
+    {
+        if (name == "scale")
+        {
+            spawn_clients(std::max(100, options.nr_clients));
+        } else if (name == "color-filter-4k")
+        {
+            setup_color_filter(true);
+        } else if (name == "tile-relayout")
+        {
+            spawn_clients(std::max(30, options.nr_clients));
+        } else if (name == "ipc-events")
+        {
+            spawn_clients(std::max(200, options.nr_clients));
+        }
+
+        // Let the clients settle before measuring
+        wait_ms(300);
+        ipc.call("stipc/frame_stats/start");
+
+        auto start   = std::chrono::steady_clock::now();
+        int ev_count = 0;
+        if (name == "move-drag")
+        {
+            ev_count = scenario_move_drag();
+        } else if (name == "expo")
+        {
+            ev_count = scenario_toggle("expo/toggle", 600);
+        } else if (name == "scale")
+        {
+            ev_count = scenario_toggle("scale/toggle", 800);
+        } else if (name == "workspace-switch")
+        {
+            ev_count = scenario_workspace_switch();
+        } else if (name == "color-filter-4k")
+        {
+            ev_count = scenario_color_filter();
+        } else if (name == "tile-relayout")
+        {
+            ev_count = scenario_tile_relayout();
+        } else if (name == "ipc-events")
+        {
+            ev_count = scenario_ipc_events();
+        } else if (name == "spawn")
+        {
+            ev_count = scenario_spawn();
+        } else
+        {
+            throw std::runtime_error("Unknown scenario " + name);
+        }
+
+        auto duration = std::chrono::steady_clock::now() - start;
+        auto stats    = ipc.call("stipc/frame_stats/stop");
+        if (name == "color-filter-4k")
+        {
+            setup_color_filter(false);
+        }
+
+        std::vector<double> frame_ms, cpu_ms, allocations;
+        int64_t damage_frames = 0, rects_before = 0, rects_after = 0;
+        for (size_t i = 0; i < stats["outputs"].size(); i++)
+        {
+            auto output = stats["outputs"][i];
+            damage_frames += output["damage-frames"].as_int64();
+            rects_before  += output["damage-rects-before"].as_int64();
+            rects_after   += output["damage-rects-after"].as_int64();
+            for (size_t j = 0; j < output["frame-ms"].size(); j++)
+            {
+                frame_ms.push_back(output["frame-ms"][j].as_double());
+                cpu_ms.push_back(output["cpu-ms"][j].as_double());
+            }
+
+            if (output.has_member("allocations"))
+            {
+                for (size_t j = 0; j < output["allocations"].size(); j++)
+                {
+                    allocations.push_back(output["allocations"][j].as_int64());
+                }
+            }
+        }
+
+        wf::json_t result;
+        result["duration-ms"] =
+            (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+        result["frame-ms"]   = summarize(frame_ms);
+        result["cpu-ms"]     = summarize(cpu_ms);
+        result["ipc-events"] = ev_count;
+        result["ipc-events-per-second"] =
+            ev_count / std::max(0.001, std::chrono::duration<double>(duration).count());
+        result["damage-rects-per-frame"]["before"] = damage_frames ? (double)rects_before / damage_frames : 0.0;
+        result["damage-rects-per-frame"]["after"]  = damage_frames ? (double)rects_after / damage_frames : 0.0;
+        if (options.alloc_stats)
+        {
+            result["allocations"] = summarize(allocations);
+        }
+
+        if (name == "spawn")
+        {
+            result["spawn-ms"] = summarize(spawn_ms);
+        }
+
+        return result;
+    }
+};
+
+int main(int argc, char **argv)
+{
+    bench_options_t options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto next = [&] () -> std::string
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "wf-bench: missing value for " << arg << std::endl;
+                exit(EXIT_FAILURE);
+            }
+
+            return argv[++i];
+        };
+
+        if (arg == "--wayfire")
+        {
+            options.wayfire = next();
+        } else if (arg == "--client")
+        {
+            options.client = next();
+        } else if (arg == "--clients")
+        {
+            options.nr_clients = std::stoi(next());
+        } else if (arg == "--renderer")
+        {
+            options.renderer = next();
+        } else if (arg == "--scenario")
+        {
+            options.scenarios.push_back(next());
+        } else if (arg == "--output")
+        {
+            options.output = next();
+        } else if (arg == "--alloc-stats")
+        {
+            options.alloc_stats = true;
+        } else
+        {
+            std::cerr << "wf-bench: unknown argument " << arg << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.client.empty())
+    {
+        std::cerr << "wf-bench: --client is required" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (options.scenarios.empty())
+    {
+        options.scenarios = {"move-drag", "expo", "workspace-switch", "scale"};
+    }
+
+    wf::json_t report;
+    try {
+        benchmark_t bench{options};
+        report = bench.run();
+    } catch (const std::exception& e)
+    {
+        std::cerr << "wf-bench: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string serialized;
+    report.map_serialized([&] (const char *buffer, size_t size)
+    {
+        serialized = std::string{buffer, size};
+    });
+
+    if (options.output.empty())
+    {
+        std::cout << serialized << std::endl;
+    } else
+    {
+        std::ofstream(options.output) << serialized << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/view-transform.hpp>
+
+static bool regions_equal(const wf::region_t& a, const wf::region_t& b)
+{
+    // operator ^ subtracts the second region from the first
+    return (a ^ b).empty() && (b ^ a).empty();
+}
+
+static wf::render_target_t make_target(float scale, int transform)
+{
+    wf::geometry_t geometry = {1920, 120, 800, 600};
+    wf::dimensions_t size   = {(int)(geometry.width * scale), (int)(geometry.height * scale)};
+    if (transform & 1)
+    {
+        std::swap(size.width, size.height);
+    }
+
+    wf::render_target_t target{wf::render_buffer_t{nullptr, size}};
+    target.geometry     = geometry;
+    target.scale        = scale;
+    target.wl_transform = (wl_output_transform)transform;
+    return target;
+}
+
+static wf::region_t make_damage()
+{
+    wf::region_t damage;
+    for (int i = 0; i < 20; i++)
+    {
+        damage |= wf::geometry_t{1920 + (i * 37) % 780, 120 + (i * 53) % 580, 7 + i % 13, 11 + i % 5};
+    }
+
+    return damage;
+}
+
+static void check_same_pixels(const std::function<wf::pointf_t(wf::pointf_t)>& to_local)
+{
+    for (int transform = WL_OUTPUT_TRANSFORM_NORMAL; transform <= WL_OUTPUT_TRANSFORM_FLIPPED_270;
+         transform++)
+    {
+        for (float scale : {1.0f, 1.25f, 1.5f, 2.0f, 3.0f})
+        {
+            CAPTURE(transform);
+            CAPTURE(scale);
+
+            auto target = make_target(scale, transform);
+            auto damage = make_damage();
+            auto direct = wf::scene::direct_render_target(target, damage, to_local);
+            REQUIRE(direct.has_value());
+
+            // The buffered path paints the damage of the transformer on the target, the direct
+            // path paints the children's damage on the children's target.
+            auto buffered_pixels = target.framebuffer_region_from_geometry_region(damage);
+            auto direct_pixels   = direct->first.framebuffer_region_from_geometry_region(direct->second);
+            REQUIRE(regions_equal(buffered_pixels, direct_pixels));
+        }
+    }
+}
+
+TEST_CASE("Direct rendering paints the same pixels as the buffered path")
+{
+    SUBCASE("Translation")
+    {
+        check_same_pixels([] (wf::pointf_t point) { return wf::pointf_t{point.x + 137, point.y - 42}; });
+    }
+
+    SUBCASE("Scaled to 1/2 around the center of the view")
+    {
+        const wf::pointf_t center = {2100, 400};
+        check_same_pixels([&] (wf::pointf_t point)
+        {
+            return wf::pointf_t{center.x + (point.x - center.x) * 2, center.y + (point.y - center.y) * 2};
+        });
+    }
+}
+
+TEST_CASE("Direct rendering snaps the origin when framebuffer pixels cover whole child pixels")
+{
+    auto target = make_target(1.0, WL_OUTPUT_TRANSFORM_NORMAL);
+    auto damage = make_damage();
+
+    auto scaled = [] (wf::pointf_t point) { return wf::pointf_t{point.x * 2 + 0.5, point.y * 2 + 0.5}; };
+    auto direct = wf::scene::direct_render_target(target, damage, scaled);
+    REQUIRE(direct.has_value());
+    REQUIRE(direct->first.scale == doctest::Approx(0.5));
+
+    auto buffered_pixels = target.framebuffer_region_from_geometry_region(damage);
+    auto direct_pixels   = direct->first.framebuffer_region_from_geometry_region(direct->second);
+    REQUIRE(regions_equal(buffered_pixels, direct_pixels));
+}
+
+TEST_CASE("Direct rendering is refused for inexact mappings")
+{
+    auto target = make_target(1.5, WL_OUTPUT_TRANSFORM_NORMAL);
+    auto damage = make_damage();
+
+    auto fractional = [] (wf::pointf_t point) { return wf::pointf_t{point.x + 0.5, point.y}; };
+    REQUIRE(!wf::scene::direct_render_target(target, damage, fractional));
+
+    auto non_uniform = [] (wf::pointf_t point) { return wf::pointf_t{point.x * 2, point.y * 3}; };
+    REQUIRE(!wf::scene::direct_render_target(target, damage, non_uniform));
+
+    auto enlarged = [] (wf::pointf_t point) { return wf::pointf_t{point.x / 2, point.y / 2}; };
+    REQUIRE(!wf::scene::direct_render_target(target, damage, enlarged));
+
+    auto flipped = [] (wf::pointf_t point) { return wf::pointf_t{-point.x, -point.y}; };
+    REQUIRE(!wf::scene::direct_render_target(target, damage, flipped));
+}
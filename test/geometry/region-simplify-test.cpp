@@ -0,0 +1,101 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/region.hpp>
+
+static int64_t region_area(const wf::region_t& region)
+{
+    int64_t area = 0;
+    for (const auto& box : region)
+    {
+        area += int64_t(box.x2 - box.x1) * (box.y2 - box.y1);
+    }
+
+    return area;
+}
+
+static bool region_contains(const wf::region_t& a, const wf::region_t& b)
+{
+    wf::region_t outside = b;
+    outside ^= a;
+    return outside.empty();
+}
+
+/* A row of glyphs separated by 2px */
+static wf::region_t glyph_damage(int rows, int columns)
+{
+    wf::region_t damage;
+    for (int r = 0; r < rows; r++)
+    {
+        for (int c = 0; c < columns; c++)
+        {
+            damage |= wf::geometry_t{c * 14, r * 20, 12, 16};
+        }
+    }
+
+    return damage;
+}
+
+TEST_CASE("Simplification without overhead keeps the region")
+{
+    auto damage = glyph_damage(5, 10);
+    auto simplified = damage;
+    simplified.simplify(0.0);
+    REQUIRE(simplified.rect_count() == damage.rect_count());
+    REQUIRE(region_area(simplified) == region_area(damage));
+}
+
+TEST_CASE("Simplification respects the area overhead")
+{
+    auto damage = glyph_damage(5, 10);
+    for (double overhead : {0.05, 0.1, 0.5})
+    {
+        CAPTURE(overhead);
+        auto simplified = damage;
+        simplified.simplify(overhead);
+        REQUIRE(region_contains(simplified, damage));
+        REQUIRE(simplified.rect_count() < damage.rect_count());
+        REQUIRE(region_area(simplified) <= region_area(damage) * (1.0 + overhead));
+    }
+
+    // Boxes merged across bands overlap the rects of the next bands
+    wf::region_t stairs;
+    for (int i = 0; i < 30; i++)
+    {
+        stairs |= wf::geometry_t{i * 7, i * 5, 12, 16};
+    }
+
+    for (double overhead : {0.05, 0.1, 0.25, 0.5})
+    {
+        CAPTURE(overhead);
+        auto simplified = stairs;
+        simplified.simplify(overhead);
+        REQUIRE(region_contains(simplified, stairs));
+        REQUIRE(region_area(simplified) <= region_area(stairs) * (1.0 + overhead));
+    }
+}
+
+TEST_CASE("Simplification caps the number of rects")
+{
+    auto damage = glyph_damage(20, 20);
+    for (int max_rects : {1, 4, 16, 64})
+    {
+        CAPTURE(max_rects);
+        auto simplified = damage;
+        simplified.simplify(0.0, max_rects);
+        REQUIRE(region_contains(simplified, damage));
+        REQUIRE(simplified.rect_count() <= max_rects);
+    }
+
+    // Scattered boxes
+    wf::region_t scattered;
+    for (int i = 0; i < 100; i++)
+    {
+        scattered |= wf::geometry_t{(i * 97) % 1900, (i * 61) % 1000, 5 + i % 7, 5 + i % 3};
+    }
+
+    auto simplified = scattered;
+    simplified.simplify(0.1, 8);
+    REQUIRE(region_contains(simplified, scattered));
+    REQUIRE(simplified.rect_count() <= 8);
+}
@@ -0,0 +1,112 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/render.hpp>
+#include <wayfire/region.hpp>
+
+/* The reference implementation: transform each box and union them one by one. */
+static wf::region_t reference_to_framebuffer(const wf::render_target_t& target, const wf::region_t& region)
+{
+    wf::region_t result;
+    for (const auto& rect : region)
+    {
+        result |= target.framebuffer_box_from_geometry_box(wlr_box_from_pixman_box(rect));
+    }
+
+    return result;
+}
+
+static wf::region_t reference_to_geometry(const wf::render_target_t& target, const wf::region_t& region)
+{
+    wf::region_t result;
+    for (const auto& rect : region)
+    {
+        result |= target.geometry_box_from_framebuffer_box(wlr_box_from_pixman_box(rect));
+    }
+
+    return result;
+}
+
+static bool region_contains(const wf::region_t& a, const wf::region_t& b)
+{
+    wf::region_t outside = b;
+    outside ^= a;
+    return outside.empty();
+}
+
+static bool regions_equal(const wf::region_t& a, const wf::region_t& b)
+{
+    return region_contains(a, b) && region_contains(b, a);
+}
+
+static wf::region_t make_damage(wf::geometry_t area, int nr_rects)
+{
+    wf::region_t damage;
+    for (int i = 0; i < nr_rects; i++)
+    {
+        // Small, partially overlapping rects, like the cursor and glyph damage of a terminal
+        int x = area.x + (i * 37) % std::max(1, area.width - 20);
+        int y = area.y + (i * 53) % std::max(1, area.height - 20);
+        damage |= wf::geometry_t{x, y, 7 + i % 13, 11 + i % 5};
+    }
+
+    return damage;
+}
+
+TEST_CASE("Batch region transforms match per-box transforms")
+{
+    const float scales[] = {1.0, 1.25, 1.5, 1.75, 2.0, 3.0};
+    for (int transform = WL_OUTPUT_TRANSFORM_NORMAL; transform <= WL_OUTPUT_TRANSFORM_FLIPPED_270;
+         transform++)
+    {
+        for (float scale : scales)
+        {
+            for (bool use_subbuffer : {false, true})
+            {
+                CAPTURE(transform);
+                CAPTURE(scale);
+                CAPTURE(use_subbuffer);
+
+                wf::geometry_t geometry = {1920, 120, 800, 600};
+                wf::dimensions_t size   = {(int)(geometry.width * scale), (int)(geometry.height * scale)};
+                if (transform & 1)
+                {
+                    std::swap(size.width, size.height);
+                }
+
+                wf::render_target_t target{wf::render_buffer_t{nullptr, size}};
+                target.geometry     = geometry;
+                target.scale        = scale;
+                target.wl_transform = (wl_output_transform)transform;
+                if (use_subbuffer)
+                {
+                    target.subbuffer = wf::geometry_t{10, 20, size.width / 2, size.height / 2};
+                }
+
+                for (int nr_rects : {0, 1, 5, 50})
+                {
+                    auto damage = make_damage(geometry, nr_rects);
+                    auto fb_damage = target.framebuffer_region_from_geometry_region(damage);
+                    REQUIRE(regions_equal(fb_damage, reference_to_framebuffer(target, damage)));
+
+                    // Going back to geometry coordinates divides by the scale, so the per-box path
+                    // may round a box up by a pixel where the batch path does not. The batch result
+                    // must still cover the original damage.
+                    auto geometry_damage = target.geometry_region_from_framebuffer_region(fb_damage);
+                    REQUIRE(region_contains(reference_to_geometry(target, fb_damage), geometry_damage));
+                    REQUIRE(region_contains(geometry_damage, damage));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Batch region transform of a full buffer")
+{
+    wf::render_target_t target{wf::render_buffer_t{nullptr, {1080, 1920}}};
+    target.geometry     = {0, 0, 1920, 1080};
+    target.wl_transform = WL_OUTPUT_TRANSFORM_90;
+
+    auto fb_damage = target.framebuffer_region_from_geometry_region(wf::region_t{target.geometry});
+    REQUIRE(regions_equal(fb_damage, wf::region_t{wf::geometry_t{0, 0, 1080, 1920}}));
+}
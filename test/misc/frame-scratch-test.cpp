@@ -0,0 +1,87 @@
+#include "main.hpp"
+#include "config.h"
+#include <wayfire/debug.hpp>
+#include <wayfire/render.hpp>
+#include <wayfire/scene-render.hpp>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+TEST_CASE("Instruction lists are reused with their capacity")
+{
+    wf::frame_scratch_arena_t arena;
+    auto list = arena.acquire_instructions();
+    list->resize(64);
+    auto data = list->data();
+    arena.release_instructions(list);
+
+    auto reused = arena.acquire_instructions();
+    REQUIRE(reused == list);
+    REQUIRE(reused->empty());
+    REQUIRE(reused->capacity() >= 64);
+    REQUIRE(reused->data() == data);
+
+    // Nested passes get distinct lists
+    auto nested = arena.acquire_instructions();
+    REQUIRE(nested != reused);
+    arena.release_instructions(nested);
+    arena.release_instructions(reused);
+}
+
+TEST_CASE("Arena releases memory which is no longer needed")
+{
+    wf::frame_scratch_arena_t arena;
+    auto big = arena.acquire_instructions();
+    auto small = arena.acquire_instructions();
+    big->resize(1000);
+    arena.release_instructions(small);
+    arena.release_instructions(big);
+
+    // Run enough frames which need a single short list
+    for (int i = 0; i < 1000; i++)
+    {
+        auto list = arena.acquire_instructions();
+        list->resize(10);
+        arena.release_instructions(list);
+        arena.reset();
+    }
+
+    auto first  = arena.acquire_instructions();
+    auto second = arena.acquire_instructions();
+    REQUIRE(first->capacity() < 1000);
+    REQUIRE(second->capacity() == 0);
+    arena.release_instructions(second);
+    arena.release_instructions(first);
+}
+
+#if WF_ALLOC_STATS
+TEST_CASE("Allocations are accounted only during frames")
+{
+    wf::alloc_stats::enable();
+    wf::alloc_stats::reset();
+
+    // Call operator new directly, so that the compiler cannot elide the allocations
+    void *outside = ::operator new(32);
+    ::operator delete(outside);
+    REQUIRE(wf::alloc_stats::get_frame_allocations() == 0);
+
+    wf::alloc_stats::begin_frame();
+    void *first = ::operator new(32);
+    void *second = ::operator new(64);
+    wf::alloc_stats::end_frame();
+    ::operator delete(first);
+    ::operator delete(second);
+
+    REQUIRE(wf::alloc_stats::get_frame_allocations() == 2);
+    REQUIRE(wf::alloc_stats::get_frame_count() == 1);
+
+    auto sites = wf::alloc_stats::get_call_sites(10);
+    uint64_t total = 0;
+    for (auto& site : sites)
+    {
+        total += site.allocations;
+    }
+
+    REQUIRE(total == 2);
+    REQUIRE(wf::alloc_stats::get_call_sites(1).size() == 1);
+}
+#endif
@@ -0,0 +1,89 @@
+#include "../../plugins/ipc-rules/generation-tracker.hpp"
+#include <algorithm>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using wf::ipc_rules::generation_tracker_t;
+
+TEST_CASE("Changes and removals since a generation")
+{
+    generation_tracker_t tracker{100};
+    tracker.sync({1, 2, 3});
+    auto first = tracker.get_generation();
+    REQUIRE(first > 100);
+    REQUIRE(tracker.can_diff(100));
+    REQUIRE(tracker.changed_since(1, 100));
+    REQUIRE(!tracker.changed_since(1, first));
+
+    tracker.bump(2);
+    tracker.sync({2, 3, 4});
+    auto second = tracker.get_generation();
+    REQUIRE(tracker.can_diff(first));
+    REQUIRE(tracker.changed_since(2, first));
+    REQUIRE(!tracker.changed_since(3, first));
+    REQUIRE(tracker.changed_since(4, first));
+    REQUIRE(tracker.removed_since(first) == std::vector<uint64_t>{1});
+    REQUIRE(tracker.removed_since(second).empty());
+
+    // Unknown ids are always reported as changed
+    REQUIRE(tracker.changed_since(42, second));
+
+    tracker.bump_all();
+    REQUIRE(tracker.changed_since(3, second));
+}
+
+TEST_CASE("Generations from another instance need a full list")
+{
+    generation_tracker_t old_tracker{100};
+    old_tracker.sync({1, 2});
+    old_tracker.bump(1);
+
+    generation_tracker_t tracker{200};
+    tracker.sync({1, 2});
+    REQUIRE(!tracker.can_diff(old_tracker.get_generation()));
+    REQUIRE(!tracker.can_diff(0));
+    REQUIRE(!tracker.can_diff(tracker.get_generation() + 1));
+    REQUIRE(tracker.can_diff(200));
+    REQUIRE(tracker.can_diff(tracker.get_generation()));
+
+    // By default, a newer tracker starts after all generations of an older one
+    generation_tracker_t current;
+    REQUIRE(!current.can_diff(tracker.get_generation()));
+}
+
+TEST_CASE("Diffs are refused after removals were forgotten")
+{
+    generation_tracker_t tracker{0};
+    const size_t nr_objects = generation_tracker_t::MAX_REMOVED + 10;
+    std::vector<uint64_t> ids;
+    for (size_t i = 0; i < nr_objects; i++)
+    {
+        ids.push_back(i + 1);
+    }
+
+    tracker.sync(ids);
+    auto before = tracker.get_generation();
+    REQUIRE(tracker.can_diff(before));
+
+    // Remove the objects one by one, so that each removal has its own generation
+    std::vector<uint64_t> generations;
+    while (!ids.empty())
+    {
+        ids.pop_back();
+        tracker.sync(ids);
+        generations.push_back(tracker.get_generation());
+    }
+
+    // The first removals were forgotten, a client which has not seen them
+    // needs the full list.
+    REQUIRE(!tracker.can_diff(before));
+    REQUIRE(!tracker.can_diff(generations[8]));
+
+    // A client which has seen them gets exactly the remaining removals
+    REQUIRE(tracker.can_diff(generations[9]));
+    auto removed = tracker.removed_since(generations[9]);
+    REQUIRE(removed.size() == generation_tracker_t::MAX_REMOVED);
+    REQUIRE(std::find(removed.begin(), removed.end(), nr_objects - 9) == removed.end());
+    REQUIRE(std::find(removed.begin(), removed.end(), nr_objects - 10) != removed.end());
+    REQUIRE(std::find(removed.begin(), removed.end(), 1) != removed.end());
+}
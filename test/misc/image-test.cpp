@@ -0,0 +1,272 @@
+#include "core/img-impl.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+static image_io::decoded_image_t make_image(int width, int height, int channels,
+    std::vector<uint8_t> data)
+{
+    image_io::decoded_image_t image;
+    image.width    = width;
+    image.height   = height;
+    image.channels = channels;
+    image.data     = std::move(data);
+    return image;
+}
+
+TEST_CASE("Scaling down averages the covered pixels")
+{
+    auto image = make_image(4, 2, 3, {
+        0, 0, 0, 10, 20, 30, 100, 100, 100, 200, 200, 200,
+        20, 40, 60, 30, 40, 50, 100, 100, 100, 0, 0, 0,
+    });
+
+    image_io::scale_image(image, {2, 1});
+    REQUIRE(image.width == 2);
+    REQUIRE(image.height == 1);
+    REQUIRE(image.channels == 3);
+    REQUIRE(image.data == std::vector<uint8_t>{15, 25, 35, 100, 100, 100});
+}
+
+TEST_CASE("Scaling up interpolates between pixels")
+{
+    auto image = make_image(2, 1, 4, {0, 0, 0, 255, 200, 100, 40, 255});
+
+    image_io::scale_image(image, {4, 1});
+    REQUIRE(image.width == 4);
+    REQUIRE(image.height == 1);
+    REQUIRE(image.data == std::vector<uint8_t>{
+        0, 0, 0, 255,
+        50, 25, 10, 255,
+        150, 75, 30, 255,
+        200, 100, 40, 255,
+    });
+}
+
+TEST_CASE("Scaling to an empty or the same size does nothing")
+{
+    auto image    = make_image(2, 1, 4, {1, 2, 3, 4, 5, 6, 7, 8});
+    auto original = image.data;
+
+    image_io::scale_image(image, {0, 0});
+    REQUIRE(image.width == 2);
+    REQUIRE(image.data == original);
+
+    image_io::scale_image(image, {2, 1});
+    REQUIRE(image.data == original);
+}
+
+TEST_CASE("Cache keys change with the file and the target size")
+{
+    struct stat st = {};
+    st.st_mtim.tv_sec  = 100;
+    st.st_mtim.tv_nsec = 5;
+
+    auto key = image_io::cache_key("/a.png", st, {1920, 1080});
+    REQUIRE(key == image_io::cache_key("/a.png", st, {1920, 1080}));
+    REQUIRE(key != image_io::cache_key("/b.png", st, {1920, 1080}));
+    REQUIRE(key != image_io::cache_key("/a.png", st, {1080, 1920}));
+    REQUIRE(key != image_io::cache_key("/a.png", st, {0, 0}));
+
+    auto modified = st;
+    modified.st_mtim.tv_nsec = 6;
+    REQUIRE(key != image_io::cache_key("/a.png", modified, {1920, 1080}));
+
+    REQUIRE(image_io::cache_entry_path("/cache", key) ==
+        image_io::cache_entry_path("/cache", key));
+    REQUIRE(image_io::cache_entry_path("/cache", key).rfind("/cache/", 0) == 0);
+}
+
+TEST_CASE("Cache entries are invalidated when the source changes")
+{
+    char dir_template[] = "/tmp/wf-image-cache-XXXXXX";
+    REQUIRE(mkdtemp(dir_template) != nullptr);
+    std::string dir = std::string(dir_template) + "/cache";
+
+    std::string source = std::string(dir_template) + "/source.png";
+    std::ofstream{source} << "not really a png";
+
+    struct stat st;
+    REQUIRE(stat(source.c_str(), &st) == 0);
+    auto key  = image_io::cache_key(source, st, {2, 1});
+    auto path = image_io::cache_entry_path(dir, key);
+
+    image_io::decoded_image_t image;
+    REQUIRE(!image_io::read_cache_entry(path, key, image));
+
+    auto stored = make_image(2, 1, 3, {1, 2, 3, 4, 5, 6});
+    image_io::write_cache_entry(dir, path, key, stored);
+    REQUIRE(image_io::read_cache_entry(path, key, image));
+    REQUIRE(image.width == 2);
+    REQUIRE(image.height == 1);
+    REQUIRE(image.channels == 3);
+    REQUIRE(image.data == stored.data);
+
+    // Touching the source file gives a new key, the old entry does not match it
+    struct timespec times[2] = {st.st_atim, st.st_mtim};
+    times[1].tv_sec += 10;
+    REQUIRE(utimensat(AT_FDCWD, source.c_str(), times, 0) == 0);
+    REQUIRE(stat(source.c_str(), &st) == 0);
+    auto new_key = image_io::cache_key(source, st, {2, 1});
+    REQUIRE(new_key != key);
+    REQUIRE(!image_io::read_cache_entry(path, new_key, image));
+    REQUIRE(!image_io::read_cache_entry(image_io::cache_entry_path(dir, new_key),
+        new_key, image));
+
+    std::filesystem::remove_all(dir_template);
+}
+
+TEST_CASE("Decoding corrupt files fails without exiting")
+{
+    image_io::init();
+
+    char dir_template[] = "/tmp/wf-image-decode-XXXXXX";
+    REQUIRE(mkdtemp(dir_template) != nullptr);
+    std::string dir = dir_template;
+
+    const std::pair<std::string, std::string> files[] = {
+        {"garbage.jpg", "not really a jpeg"},
+        {"truncated.jpg", "\xFF\xD8"},
+        {"garbage.png", "not really a png"},
+    };
+
+    for (auto& [name, contents] : files)
+    {
+        CAPTURE(name);
+        std::ofstream{dir + "/" + name, std::ios::binary} << contents;
+
+        image_io::decoded_image_t image;
+        REQUIRE(!image_io::decode_file(dir + "/" + name, image));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+/* A straightforward QOI decoder, following the specification */
+static std::vector<uint8_t> decode_qoi(const std::vector<uint8_t>& data, int& w, int& h)
+{
+    auto get_u32 = [&] (size_t pos)
+    {
+        return (uint32_t)data[pos] << 24 | (uint32_t)data[pos + 1] << 16 |
+               (uint32_t)data[pos + 2] << 8 | data[pos + 3];
+    };
+
+    REQUIRE(data.size() >= 22);
+    REQUIRE(std::string(data.begin(), data.begin() + 4) == "qoif");
+    w = get_u32(4);
+    h = get_u32(8);
+    REQUIRE(data[12] == 4);
+
+    std::vector<uint8_t> pixels;
+    uint8_t index[64][4] = {};
+    uint8_t px[4] = {0, 0, 0, 255};
+    size_t pos = 14;
+    while (pixels.size() < (size_t)w * h * 4)
+    {
+        REQUIRE(pos < data.size() - 8);
+        uint8_t op = data[pos++];
+        int run    = 1;
+        if (op == 0xfe)
+        {
+            px[0] = data[pos++];
+            px[1] = data[pos++];
+            px[2] = data[pos++];
+        } else if (op == 0xff)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                px[c] = data[pos++];
+            }
+        } else if ((op & 0xc0) == 0x00)
+        {
+            memcpy(px, index[op], 4);
+        } else if ((op & 0xc0) == 0x40)
+        {
+            px[0] += ((op >> 4) & 3) - 2;
+            px[1] += ((op >> 2) & 3) - 2;
+            px[2] += (op & 3) - 2;
+        } else if ((op & 0xc0) == 0x80)
+        {
+            int dg = (op & 0x3f) - 32;
+            uint8_t next = data[pos++];
+            px[0] += dg + (next >> 4) - 8;
+            px[1] += dg;
+            px[2] += dg + (next & 0x0f) - 8;
+        } else
+        {
+            run = (op & 0x3f) + 1;
+        }
+
+        memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+        for (int i = 0; i < run; i++)
+        {
+            pixels.insert(pixels.end(), px, px + 4);
+        }
+    }
+
+    REQUIRE(std::vector<uint8_t>(data.begin() + pos, data.end()) ==
+        std::vector<uint8_t>{0, 0, 0, 0, 0, 0, 0, 1});
+    return pixels;
+}
+
+TEST_CASE("QOI encoding of a known image")
+{
+    std::vector<uint8_t> pixels = {0, 0, 0, 255, 255, 0, 0, 255};
+    auto data = image_io::encode_qoi(pixels.data(), 2, 1, false);
+    REQUIRE(data == std::vector<uint8_t>{
+        'q', 'o', 'i', 'f', 0, 0, 0, 2, 0, 0, 0, 1, 4, 0,
+        0xc0, // run of one pixel equal to the initial {0, 0, 0, 255}
+        0x5a, // diff, red - 1 with wraparound
+        0, 0, 0, 0, 0, 0, 0, 1,
+    });
+}
+
+TEST_CASE("QOI encoding round-trips")
+{
+    const int w = 37, h = 23;
+    std::vector<uint8_t> pixels((size_t)w * h * 4);
+    uint32_t state = 1;
+    for (size_t i = 0; i < pixels.size(); i += 4)
+    {
+        state = state * 1103515245 + 12345;
+        if ((state >> 28) < 6)
+        {
+            // Long runs and repeated colors, so that all ops are used
+            size_t prev = (i >= 4) ? i - 4 : 0;
+            std::copy_n(pixels.begin() + prev, 4, pixels.begin() + i);
+            pixels[i + 1] += (state >> 20) & 3;
+            continue;
+        }
+
+        for (int c = 0; c < 4; c++)
+        {
+            pixels[i + c] = state >> (8 * c);
+        }
+
+        if ((state >> 27) & 1)
+        {
+            pixels[i + 3] = 255;
+        }
+    }
+
+    int dw, dh;
+    REQUIRE(decode_qoi(image_io::encode_qoi(pixels.data(), w, h, false), dw, dh) == pixels);
+    REQUIRE(dw == w);
+    REQUIRE(dh == h);
+
+    std::vector<uint8_t> flipped;
+    for (int i = h - 1; i >= 0; i--)
+    {
+        flipped.insert(flipped.end(), pixels.begin() + i * w * 4, pixels.begin() + (i + 1) * w * 4);
+    }
+
+    REQUIRE(decode_qoi(image_io::encode_qoi(pixels.data(), w, h, true), dw, dh) == flipped);
+
+    std::vector<uint8_t> same(4 * 200, 7);
+    REQUIRE(decode_qoi(image_io::encode_qoi(same.data(), 10, 20, false), dw, dh) == same);
+}
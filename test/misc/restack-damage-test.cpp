@@ -0,0 +1,104 @@
+#include <wayfire/scene.hpp>
+#include <wayfire/scene-render.hpp>
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+class box_node_t : public wf::scene::node_t
+{
+  public:
+    box_node_t(wf::geometry_t box) : node_t(false), box(box)
+    {}
+
+    wf::geometry_t get_bounding_box() override
+    {
+        return box;
+    }
+
+  private:
+    wf::geometry_t box;
+};
+
+static bool same_region(const wf::region_t& a, const wf::region_t& b)
+{
+    // operator ^ subtracts the second region from the first
+    return (a ^ b).empty() && (b ^ a).empty();
+}
+
+struct restack_fixture_t
+{
+    std::shared_ptr<wf::scene::floating_inner_node_t> parent =
+        std::make_shared<wf::scene::floating_inner_node_t>(false);
+    std::vector<wf::scene::node_ptr> nodes;
+    wf::region_t damage;
+    wf::signal::connection_t<wf::scene::node_damage_signal> on_damage =
+        [=] (wf::scene::node_damage_signal *ev) { damage |= ev->region; };
+
+    restack_fixture_t()
+    {
+        // Three overlapping windows and one which does not overlap any of them
+        nodes.push_back(std::make_shared<box_node_t>(wf::geometry_t{0, 0, 100, 100}));
+        nodes.push_back(std::make_shared<box_node_t>(wf::geometry_t{50, 50, 100, 100}));
+        nodes.push_back(std::make_shared<box_node_t>(wf::geometry_t{80, 0, 100, 100}));
+        nodes.push_back(std::make_shared<box_node_t>(wf::geometry_t{500, 500, 10, 10}));
+        parent->set_children_list(nodes);
+        parent->connect(&on_damage);
+    }
+
+    void set_order(std::vector<int> order)
+    {
+        std::vector<wf::scene::node_ptr> list;
+        for (int i : order)
+        {
+            list.push_back(nodes[i]);
+        }
+
+        damage.clear();
+        parent->set_children_list(list);
+    }
+};
+
+TEST_CASE("Raising a node damages only where it overlaps the nodes it crossed")
+{
+    restack_fixture_t fixture;
+    auto stats_before = wf::scene::get_restack_stats();
+
+    fixture.set_order({1, 0, 2, 3});
+    wf::region_t expected{wf::geometry_t{50, 50, 50, 50}};
+    REQUIRE(same_region(fixture.damage, expected));
+
+    auto stats = wf::scene::get_restack_stats();
+    REQUIRE(stats.restacks == stats_before.restacks + 1);
+    REQUIRE(stats.damaged_pixels == stats_before.damaged_pixels + 50 * 50);
+
+    // Raising the last node crosses all others, but overlaps none of them
+    fixture.set_order({3, 1, 0, 2});
+    REQUIRE(fixture.damage.empty());
+}
+
+TEST_CASE("Sending a node to the back damages its overlap with all nodes below")
+{
+    restack_fixture_t fixture;
+    fixture.set_order({1, 2, 3, 0});
+
+    wf::region_t expected;
+    expected |= wf::geometry_t{50, 50, 50, 50};
+    expected |= wf::geometry_t{80, 0, 20, 100};
+    REQUIRE(same_region(fixture.damage, expected));
+}
+
+TEST_CASE("Added and removed nodes are damaged completely")
+{
+    restack_fixture_t fixture;
+    auto stats_before = wf::scene::get_restack_stats();
+
+    fixture.set_order({0, 1, 2});
+    REQUIRE(same_region(fixture.damage, wf::region_t{wf::geometry_t{500, 500, 10, 10}}));
+
+    fixture.set_order({0, 1, 2, 3});
+    REQUIRE(same_region(fixture.damage, wf::region_t{wf::geometry_t{500, 500, 10, 10}}));
+
+    // The same order again does not damage anything
+    fixture.set_order({0, 1, 2, 3});
+    REQUIRE(fixture.damage.empty());
+    REQUIRE(wf::scene::get_restack_stats().restacks == stats_before.restacks);
+}
@@ -0,0 +1,54 @@
+#include "core/opengl-priv.hpp"
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+/* Each vertex has a position and texture coordinates. */
+static constexpr size_t VERTEX_FLOATS = 4;
+
+static std::vector<GLfloat> vertex(const std::vector<GLfloat>& vertices, size_t index)
+{
+    auto start = vertices.begin() + index * VERTEX_FLOATS;
+    return {start, start + VERTEX_FLOATS};
+}
+
+TEST_CASE("Each quad is drawn as two triangles")
+{
+    std::vector<OpenGL::textured_quad_t> quads = {
+        {{0, 0, 10, 20}, {}},
+        {{100, 50, 110, 60}, {}},
+    };
+
+    std::vector<GLfloat> vertices;
+    OpenGL::append_textured_quad_vertices(quads, 0, vertices);
+    REQUIRE(vertices.size() == 2 * 6 * VERTEX_FLOATS);
+
+    // Without TEXTURE_USE_TEX_GEOMETRY, the whole texture is shown on each quad
+    REQUIRE(vertex(vertices, 0) == std::vector<GLfloat>{0, 20, 0, 0});
+    REQUIRE(vertex(vertices, 1) == std::vector<GLfloat>{10, 20, 1, 0});
+    REQUIRE(vertex(vertices, 2) == std::vector<GLfloat>{10, 0, 1, 1});
+    REQUIRE(vertex(vertices, 3) == std::vector<GLfloat>{0, 20, 0, 0});
+    REQUIRE(vertex(vertices, 4) == std::vector<GLfloat>{10, 0, 1, 1});
+    REQUIRE(vertex(vertices, 5) == std::vector<GLfloat>{0, 0, 0, 1});
+
+    REQUIRE(vertex(vertices, 6) == std::vector<GLfloat>{100, 60, 0, 0});
+    REQUIRE(vertex(vertices, 11) == std::vector<GLfloat>{100, 50, 0, 1});
+}
+
+TEST_CASE("Quads use their own texture geometry and the transform flags")
+{
+    std::vector<OpenGL::textured_quad_t> quads = {
+        {{0, 0, 10, 10}, {0.25, 0.5, 0.75, 1.0}},
+    };
+
+    std::vector<GLfloat> vertices = {42};
+    OpenGL::append_textured_quad_vertices(quads,
+        OpenGL::TEXTURE_USE_TEX_GEOMETRY | OpenGL::TEXTURE_TRANSFORM_INVERT_Y, vertices);
+
+    // Existing vertices are kept
+    REQUIRE(vertices.size() == 1 + 6 * VERTEX_FLOATS);
+    REQUIRE(vertices[0] == 42);
+    vertices.erase(vertices.begin());
+
+    REQUIRE(vertex(vertices, 0) == std::vector<GLfloat>{0, 10, 0.25, 0.5});
+    REQUIRE(vertex(vertices, 2) == std::vector<GLfloat>{10, 0, 0.75, 0.0});
+}
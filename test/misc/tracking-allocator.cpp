@@ -1,4 +1,5 @@
 #include "wayfire/nonstd/tracking-allocator.hpp"
+#include "wayfire/object.hpp"
 #include "wayfire/signal-provider.hpp"
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
@@ -55,3 +56,77 @@ TEST_CASE("Misc factory works")
     REQUIRE(destruct_events == 1);
     REQUIRE(allocator.get_all().size() == 1);
 }
+
+class object_t : public wf::object_base_t
+{};
+
+TEST_CASE("Objects are found by id and keep their order")
+{
+    auto& allocator = wf::tracking_allocator_t<object_t>::get();
+
+    std::vector<std::shared_ptr<object_t>> objects;
+    for (int i = 0; i < 5; i++)
+    {
+        objects.push_back(allocator.allocate<object_t>());
+    }
+
+    for (auto& obj : objects)
+    {
+        REQUIRE(allocator.find_by_id(obj->get_id()).get() == obj.get());
+    }
+
+    uint32_t freed_id = objects[1]->get_id();
+    objects.erase(objects.begin() + 1);
+    REQUIRE(allocator.find_by_id(freed_id) == nullptr);
+
+    auto& all = allocator.get_all();
+    REQUIRE(all.size() == 4);
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        REQUIRE(all[i].get() == objects[i].get());
+    }
+
+    objects.clear();
+    REQUIRE(allocator.get_all().empty());
+}
+
+TEST_CASE("for_each() allows freeing and allocating objects")
+{
+    auto& allocator = wf::tracking_allocator_t<object_t>::get();
+
+    std::vector<std::shared_ptr<object_t>> objects;
+    for (int i = 0; i < 6; i++)
+    {
+        objects.push_back(allocator.allocate<object_t>());
+    }
+
+    std::vector<object_t*> expected = {objects[0].get(), objects[1].get(), objects[2].get(), objects[5].get()};
+    std::vector<object_t*> visited;
+    allocator.for_each([&] (nonstd::observer_ptr<object_t> obj)
+    {
+        visited.push_back(obj.get());
+        if (obj.get() == objects[1].get())
+        {
+            // Free objects which were not visited yet, and allocate enough
+            // objects that the list is reallocated.
+            objects[3].reset();
+            objects[4].reset();
+            for (int i = 0; i < 100; i++)
+            {
+                objects.push_back(allocator.allocate<object_t>());
+            }
+
+            // Nested calls do not compact the list under the outer loop, the
+            // freed objects are left as null entries.
+            REQUIRE(allocator.get_all().size() == 106);
+            REQUIRE(allocator.get_all()[3] == nullptr);
+            REQUIRE(allocator.get_all()[4] == nullptr);
+        }
+    });
+
+    REQUIRE(visited == expected);
+    REQUIRE(allocator.get_all().size() == 104);
+
+    objects.clear();
+    REQUIRE(allocator.get_all().empty());
+}